@@ -0,0 +1,221 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <libcloudph++/blk_1m/options.hpp>
+#include <libcloudph++/common/moist_air.hpp>
+#include <libcloudph++/common/const_cp.hpp>
+#include <libcloudph++/common/theta_std.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+// saturation adjustment implementations selectable with --adj
+enum class adj_t { scalar, simd, simd_skip };
+
+// a vectorisable counterpart of libcloudphxx::blk_1m::adj_cellwise(): instead
+// of integrating the moist First Law in small increments of rv, the amount
+// of condensed (>0) or evaporated (<0) water x is found for all cells at once
+// with Newton iterations on f(x) = rv - x - r_vs(T(th + dth_drv x)) (same
+// thermodynamic formulae as in libcloudph++'s theta_dry and const_cp);
+// the cells are processed in blocks of n_lane with the lanes that converged
+// masked out and the block left once all of them converged; with skip,
+// the cells with no condensate that are subsaturated are dropped first and
+// the remaining ones are packed into contiguous (SoA) buffers; the state
+// is stored in real_t while the iterations are carried out in acc_t
+template <typename real_t, typename acc_t = real_t>
+class adj_simd_t
+{
+  static constexpr int n_lane = 16, n_iter = 10;
+
+  // thermodynamic constants
+  const acc_t
+    R_d   = libcloudphxx::common::moist_air::R_d<acc_t>().value(),
+    R_v   = libcloudphxx::common::moist_air::R_v<acc_t>().value(),
+    c_pd  = libcloudphxx::common::moist_air::c_pd<acc_t>().value(),
+    c_pv  = libcloudphxx::common::moist_air::c_pv<acc_t>().value(),
+    c_pw  = libcloudphxx::common::moist_air::c_pw<acc_t>().value(),
+    T_tri = libcloudphxx::common::const_cp::T_tri<acc_t>().value(),
+    p_tri = libcloudphxx::common::const_cp::p_tri<acc_t>().value(),
+    l_tri = libcloudphxx::common::const_cp::l_tri<acc_t>().value(),
+    p_1000 = libcloudphxx::common::theta_std::p_1000<acc_t>().value(),
+    eps   = R_d / R_v,
+    exn   = R_d / (c_pd - R_d); // T = th * (rhod R_d th / p_1000)^exn
+
+  // packed copies of the cells to be adjusted (skip mode only)
+  std::vector<real_t> rhod_p, th_p, rv_p, rc_p, rr_p;
+  std::vector<int> idx;
+
+  acc_t T(const acc_t &rhod, const acc_t &th) const
+  {
+    return th * std::pow(rhod * R_d * th / p_1000, exn);
+  }
+
+  acc_t l_v(const acc_t &T) const
+  {
+    return l_tri + (c_pv - c_pw) * (T - T_tri);
+  }
+
+  acc_t p_vs(const acc_t &T) const
+  {
+    return p_tri * std::exp(
+      (l_tri + (c_pw - c_pv) * T_tri) / R_v * (1 / T_tri - 1 / T)
+      - (c_pw - c_pv) / R_v * std::log(T / T_tri)
+    );
+  }
+
+  acc_t r_vs(const acc_t &rhod, const acc_t &rv, const acc_t &T) const
+  {
+    const acc_t p = rhod * (R_d + rv * R_v) * T, pvs = p_vs(T);
+    return eps * pvs / (p - pvs);
+  }
+
+  // adjusts n cells stored contiguously (with the evaporation toggles as compile-time constants)
+  template <bool cevp, bool revp>
+  void adj_block(
+    const libcloudphxx::blk_1m::opts_t<real_t> &opts,
+    const real_t *rhod, real_t *th, real_t *rv, real_t *rc, real_t *rr,
+    const int n
+  ) const
+  {
+    const acc_t tol = acc_t(1e-3) * opts.r_eps;
+
+    for (int b = 0; b < n; b += n_lane)
+    {
+      const int w = std::min(int(n_lane), n - b);
+
+      acc_t x[n_lane], k[n_lane], x_min[n_lane], x_max[n_lane], T0[n_lane];
+      bool done[n_lane];
+
+      // initial guess and bounds: no more than the available condensate can be evaporated
+      for (int l = 0; l < w; ++l)
+      {
+        const int c = b + l;
+        T0[l] = T(rhod[c], th[c]);
+        x[l] = 0;
+        k[l] = th[c] / T0[l] * l_v(T0[l]) / c_pd;
+        x_min[l] = -(acc_t(cevp ? rc[c] : 0) + acc_t(revp ? rr[c] : 0));
+        x_max[l] = opts.cond ? rv[c] : 0;
+        done[l] = false;
+      }
+
+      for (int it = 0; it < n_iter; ++it)
+      {
+        int n_done = 0;
+#pragma omp simd reduction(+:n_done)
+        for (int l = 0; l < w; ++l)
+        {
+          const int c = b + l;
+          const acc_t
+            th1 = th[c] + k[l] * x[l],
+            rv1 = rv[c] - x[l],
+            T1  = T(rhod[c], th1),
+            Tm  = (T0[l] + T1) / 2,
+            km  = (th[c] + th1) / 2 / Tm * l_v(Tm) / c_pd, // mid-point dth/drv
+            rs  = r_vs(rhod[c], rv1, T1),
+            L1  = l_v(T1),
+            drs_dT = rs * (eps + rs) / eps * L1 / (R_v * T1 * T1), // Clausius-Clapeyron
+            df_dx  = -1 - drs_dT * T1 / th1 / (1 - R_d / c_pd) * km,
+            xn = std::min(x_max[l], std::max(x_min[l], x[l] - (rv1 - rs) / df_dx));
+
+          const bool cnvrgd = std::abs(xn - x[l]) <= tol && std::abs(km - k[l]) <= tol * k[l];
+          x[l] = done[l] ? x[l] : xn;
+          k[l] = done[l] ? k[l] : km;
+          done[l] = done[l] || cnvrgd;
+          n_done += done[l];
+        }
+        if (n_done == w) break;
+      }
+
+      // applying the adjustment: evaporating cloud water first, then rain
+#pragma omp simd
+      for (int l = 0; l < w; ++l)
+      {
+        const int c = b + l;
+        const acc_t
+          evap = std::max(acc_t(0), -x[l]),
+          evap_c = cevp ? std::min(evap, acc_t(rc[c])) : acc_t(0);
+        th[c] = th[c] + k[l] * x[l];
+        rv[c] = rv[c] - x[l];
+        rc[c] = rc[c] + std::max(acc_t(0), x[l]) - evap_c;
+        if (revp) rr[c] = rr[c] - (evap - evap_c);
+      }
+    }
+  }
+
+  // picking the instantiation of adj_block() once per call instead of branching in every cell
+  void adj_cells(
+    const libcloudphxx::blk_1m::opts_t<real_t> &opts,
+    const real_t *rhod, real_t *th, real_t *rv, real_t *rc, real_t *rr,
+    const int n
+  ) const
+  {
+    if ( opts.cevp &&  opts.revp) adj_block<true,  true >(opts, rhod, th, rv, rc, rr, n);
+    if ( opts.cevp && !opts.revp) adj_block<true,  false>(opts, rhod, th, rv, rc, rr, n);
+    if (!opts.cevp &&  opts.revp) adj_block<false, true >(opts, rhod, th, rv, rc, rr, n);
+    if (!opts.cevp && !opts.revp) adj_block<false, false>(opts, rhod, th, rv, rc, rr, n);
+  }
+
+  public:
+
+  // supersaturation (rv / r_vs - 1) of a cell (for diagnostics)
+  acc_t ss(const acc_t &rhod, const acc_t &th, const acc_t &rv) const
+  {
+    return rv / r_vs(rhod, rv, T(rhod, th)) - 1;
+  }
+
+  // a contiguous sequence of n cells (e.g. a column)
+  void adj(
+    const libcloudphxx::blk_1m::opts_t<real_t> &opts,
+    const real_t *rhod, real_t *th, real_t *rv, real_t *rc, real_t *rr,
+    const int n,
+    const bool skip
+  )
+  {
+    if (!opts.cond) return; // as in adj_cellwise(): ignoring values of opts.cevp and opts.revp
+
+    if (!skip)
+    {
+      adj_cells(opts, rhod, th, rv, rc, rr, n);
+      return;
+    }
+
+    // packing the cells that need adjustment
+    idx.clear();
+    for (int c = 0; c < n; ++c)
+    {
+      const bool condensate = (opts.cevp && rc[c] > 0) || (opts.revp && rr[c] > 0);
+      if (condensate || rv[c] > r_vs(rhod[c], rv[c], T(rhod[c], th[c])) - opts.r_eps)
+        idx.push_back(c);
+    }
+    const int m = idx.size();
+    if (m == 0) return;
+
+    for (auto v : {&rhod_p, &th_p, &rv_p, &rc_p, &rr_p}) v->resize(m);
+    for (int p = 0; p < m; ++p)
+    {
+      rhod_p[p] = rhod[idx[p]];
+      th_p[p] = th[idx[p]];
+      rv_p[p] = rv[idx[p]];
+      rc_p[p] = rc[idx[p]];
+      rr_p[p] = rr[idx[p]];
+    }
+
+    adj_cells(opts, rhod_p.data(), th_p.data(), rv_p.data(), rc_p.data(), rr_p.data(), m);
+
+    for (int p = 0; p < m; ++p)
+    {
+      th[idx[p]] = th_p[p];
+      rv[idx[p]] = rv_p[p];
+      rc[idx[p]] = rc_p[p];
+      rr[idx[p]] = rr_p[p];
+    }
+  }
+};
@@ -0,0 +1,138 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <H5Cpp.h>
+
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h> // getpid()
+
+// model state dump in HDF5: arrays stored over the index ranges of the views passed
+// (the advectees without halos, the halos being filled by the boundary conditions
+// anyway) with their native precision, scalars stored as attributes of the root group
+class checkpoint_t
+{
+  std::string name;
+  H5::H5File h5f;
+
+  template <typename real_t>
+  static H5::PredType h5_type()
+  {
+    return sizeof(real_t) == sizeof(float) ? H5::PredType::NATIVE_FLOAT : H5::PredType::NATIVE_DOUBLE;
+  }
+
+  std::runtime_error error(const std::string &what, H5::Exception &e)
+  {
+    // H5::Exception does not derive from std::exception
+    return std::runtime_error("HDF5 error while " + what + " (" + name + "): " + e.getDetailMsg());
+  }
+
+  public:
+
+  // note: opening a file for writing truncates it
+  checkpoint_t(const std::string &name, const bool write) try :
+    name(name),
+    h5f(name, write ? H5F_ACC_TRUNC : H5F_ACC_RDONLY)
+  {}
+  catch (H5::Exception &e)
+  {
+    throw std::runtime_error("HDF5 error while opening " + name + ": " + e.getDetailMsg());
+  }
+
+  template <class arr_t>
+  void put(const std::string &dsname, const arr_t &arr)
+  {
+    using real_t = typename arr_t::T_numtype;
+    try
+    {
+      std::vector<real_t> buf;
+      buf.reserve(arr.numElements());
+      for (int i = arr.lbound(0); i <= arr.ubound(0); ++i)
+        for (int j = arr.lbound(1); j <= arr.ubound(1); ++j)
+          buf.push_back(arr(i, j));
+
+      const hsize_t shape[2] = {hsize_t(arr.extent(0)), hsize_t(arr.extent(1))};
+      h5f.createDataSet(dsname, h5_type<real_t>(), H5::DataSpace(2, shape)).write(buf.data(), h5_type<real_t>());
+    }
+    catch (H5::Exception &e) { throw error("writing " + dsname, e); }
+  }
+
+  // arr is expected to be a view of (or a reference to) the destination array
+  template <class arr_t>
+  void get(const std::string &dsname, arr_t arr)
+  {
+    using real_t = typename arr_t::T_numtype;
+    try
+    {
+      H5::DataSet dset = h5f.openDataSet(dsname);
+      hsize_t shape[2] = {0, 0};
+      if (dset.getSpace().getSimpleExtentNdims() == 2) dset.getSpace().getSimpleExtentDims(shape);
+      if (shape[0] != hsize_t(arr.extent(0)) || shape[1] != hsize_t(arr.extent(1)))
+        throw std::runtime_error("array shape mismatch for " + dsname + " in " + name + " (different grid?)");
+
+      std::vector<real_t> buf(arr.numElements());
+      dset.read(buf.data(), h5_type<real_t>());
+
+      auto it = buf.begin();
+      for (int i = arr.lbound(0); i <= arr.ubound(0); ++i)
+        for (int j = arr.lbound(1); j <= arr.ubound(1); ++j)
+          arr(i, j) = *it++;
+    }
+    catch (H5::Exception &e) { throw error("reading " + dsname, e); }
+  }
+
+  void put_attr(const std::string &attname, const int val)
+  {
+    try
+    {
+      h5f.openGroup("/").createAttribute(attname, H5::PredType::NATIVE_INT, H5::DataSpace(H5S_SCALAR))
+        .write(H5::PredType::NATIVE_INT, &val);
+    }
+    catch (H5::Exception &e) { throw error("writing " + attname, e); }
+  }
+
+  int get_attr(const std::string &attname)
+  {
+    int val;
+    try
+    {
+      h5f.openGroup("/").openAttribute(attname).read(H5::PredType::NATIVE_INT, &val);
+    }
+    catch (H5::Exception &e) { throw error("reading " + attname, e); }
+    return val;
+  }
+
+  void close()
+  {
+    try { h5f.close(); }
+    catch (H5::Exception &e) { throw error("closing", e); }
+  }
+
+  // a temporary name to write a file under before renaming it (rename() being atomic), unique 
+  // among processes (e.g. runs sharing a spinup cache file, possibly on different hosts)
+  static std::string tmp_file(const std::string &file)
+  {
+    std::random_device rd;
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), ".tmp.%ld.%08x", long(getpid()), unsigned(rd()));
+    return file + buf;
+  }
+
+  // the name of a checkpoint file in outdir
+  static std::string file(const std::string &outdir, const int timestep)
+  {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "/checkpoint%010d.h5", timestep);
+    return outdir + buf;
+  }
+};
@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <libmpdata++/bcond/cyclic_2d.hpp>
+#include <libmpdata++/bcond/open_2d.hpp>
+#include <libmpdata++/concurr/boost_thread.hpp>
+#include <libmpdata++/concurr/openmp.hpp>
+#include <libmpdata++/concurr/serial.hpp>
+
+#if defined(__has_include)
+#  if __has_include(<libmpdata++/concurr/cxx11_thread.hpp>) // not in older libmpdata++ versions
+#    include <libmpdata++/concurr/cxx11_thread.hpp>
+#    define ICICLE_CXX11_THREAD
+#  endif
+#endif
+
+#include <string>
+#include <vector>
+
+// the concurrency backends of libmpdata++ selectable at run time (see --concurr), all with
+// the boundary conditions of the setup: boost_thread and cxx11_thread (a persistent thread
+// per rank, synchronised with barriers), openmp (a parallel region per advance() call and
+// OpenMP barriers) and serial (a single rank, i.e. no synchronisation overhead at all)
+template <class solver_t>
+using concurr_boost_thread = libmpdataxx::concurr::boost_thread<solver_t,
+  libmpdataxx::bcond::cyclic, libmpdataxx::bcond::cyclic,
+  libmpdataxx::bcond::open,   libmpdataxx::bcond::open
+>;
+
+template <class solver_t>
+using concurr_openmp = libmpdataxx::concurr::openmp<solver_t,
+  libmpdataxx::bcond::cyclic, libmpdataxx::bcond::cyclic,
+  libmpdataxx::bcond::open,   libmpdataxx::bcond::open
+>;
+
+template <class solver_t>
+using concurr_serial = libmpdataxx::concurr::serial<solver_t,
+  libmpdataxx::bcond::cyclic, libmpdataxx::bcond::cyclic,
+  libmpdataxx::bcond::open,   libmpdataxx::bcond::open
+>;
+
+#if defined(ICICLE_CXX11_THREAD)
+template <class solver_t>
+using concurr_cxx11_thread = libmpdataxx::concurr::cxx11_thread<solver_t,
+  libmpdataxx::bcond::cyclic, libmpdataxx::bcond::cyclic,
+  libmpdataxx::bcond::open,   libmpdataxx::bcond::open
+>;
+#endif
+
+// the backends available in this build (each one multiplying the solver instantiations
+// of icicle, hence the ones other than boost_thread only with ICICLE_ALL_CONCURR defined)
+inline const std::vector<std::string> &concurr_names()
+{
+  static const std::vector<std::string> ret({
+    "boost_thread"
+#if defined(ICICLE_ALL_CONCURR)
+    , "openmp", "serial"
+#  if defined(ICICLE_CXX11_THREAD)
+    , "cxx11_thread"
+#  endif
+#endif
+  });
+  return ret;
+}
+
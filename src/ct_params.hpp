@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include "kin_cloud_2d_common.hpp"
+#include "icmw8_case1.hpp"
+
+// libmpdata++'s compile-time parameters (shared by icicle and the in-process benchmarks);
+// real_t is the precision of the model state, acc_t the one of the Newton iterations
+// of the SIMD saturation adjustment (adj_simd_t), e.g. float and double in the mixed mode
+template <typename real_t_ = icmw8_case1::real_t, typename acc_t_ = real_t_>
+struct ct_params_common : ct_params_default_t
+{
+  using real_t = real_t_;
+  using acc_t = acc_t_;
+  enum { n_dims = 2 };
+  enum { opts = opts::nug | opts::fct };
+  enum { rhs_scheme = solvers::euler_b };
+  enum { relax = true }; // whether the relaxation terms (see --relax) can be applied to th and rv
+};
+
+template <typename real_t_ = icmw8_case1::real_t, typename acc_t_ = real_t_>
+struct ct_params_blk_1m : ct_params_common<real_t_, acc_t_>
+{
+  enum { n_eqns = 4 };
+  struct ix { enum {th, rv, rc, rr}; };
+  enum { hint_norhs = opts::bit(ix::th) | opts::bit(ix::rv) }; // only through adjustments
+  enum { relax = false };
+};
+
+// the above with th and rv having an rhs (instantiated only if --relax is set)
+template <typename real_t_ = icmw8_case1::real_t, typename acc_t_ = real_t_>
+struct ct_params_blk_1m_relax : ct_params_blk_1m<real_t_, acc_t_>
+{
+  enum { hint_norhs = 0 };
+  enum { relax = true };
+};
+
+template <typename real_t_ = icmw8_case1::real_t, typename acc_t_ = real_t_>
+struct ct_params_blk_2m : ct_params_common<real_t_, acc_t_>
+{
+  enum { n_eqns = 6 };
+  struct ix { enum {th, rv, rc, rr, nc, nr}; };
+
+  static constexpr int hint_scale(const int &e)
+  {
+    return
+      e == ix::nc ?  24 : // 1.7e7
+      e == ix::nr ?  17 : // 1.3e5
+      e == ix::rc ? -14 : // 1.6e4
+      e == ix::rr ? -14 : // 1.6e4
+      0;
+  }
+};
+
+template <typename real_t_ = icmw8_case1::real_t, typename acc_t_ = real_t_>
+struct ct_params_lgrngn : ct_params_common<real_t_, acc_t_>
+{
+  enum { n_eqns = 2 };
+  struct ix { enum {th, rv}; };
+  enum { hint_norhs = opts::bit(ix::th) | opts::bit(ix::rv) }; // only through adjustments
+  enum { relax = false };
+};
+
+// the above with th and rv having an rhs (instantiated only if --relax is set)
+template <typename real_t_ = icmw8_case1::real_t, typename acc_t_ = real_t_>
+struct ct_params_lgrngn_relax : ct_params_lgrngn<real_t_, acc_t_>
+{
+  enum { hint_norhs = 0 };
+  enum { relax = true };
+};
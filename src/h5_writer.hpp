@@ -0,0 +1,415 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <H5Cpp.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the HDF5 library in its default build is not thread-safe: the calls made by threads that may
+// run concurrently (ranks 0 and output writers of the ensemble members, see --ensemble) are all
+// done under this lock; recursive, as the locked sections nest (e.g. an h5_writer_t used within 
+// libmpdata++'s output locked as a whole)
+inline std::recursive_mutex &h5_mutex()
+{
+  static std::recursive_mutex mtx;
+  return mtx;
+}
+
+using h5_lock_t = std::lock_guard<std::recursive_mutex>;
+
+// a field to be written to an HDF5 file (data in C order, stored as float)
+struct h5_field_t
+{
+  std::string file, name, unit;
+  bool create = false; // truncate the file before writing this field
+  std::vector<hsize_t> shape;
+  std::vector<hsize_t> chunk; // chunk dimensions (empty -> contiguous layout)
+  std::map<std::string, std::vector<double>> attrs; // numeric (1-D array) attributes of the dataset
+  std::vector<float> data;
+  int record = -1; // >= 0 -> written as the record-th entry along the time axis of an extensible (time, shape) dataset
+};
+
+// storage options applied to all fields written by h5_writer_t
+struct h5_filters_t
+{
+  std::vector<hsize_t> chunk; // chunk extent in the last two (x, z) dimensions (empty -> as in h5_field_t)
+  int deflate = 0;            // gzip level, applied after byte shuffling (0 -> no compression)
+  hsize_t records = 16;       // chunk extent along the time axis of the extensible datasets
+  std::map<std::string, int> keepbits; // mantissa bits kept per field-name prefix (the longest matching 
+                                       // one applies, "" matches all; no match -> lossless)
+
+  bool empty() const 
+  { 
+    return chunk.empty() && deflate == 0 && keepbits.empty(); 
+  }
+};
+
+// HDF5 writer keeping the last used file open
+class h5_writer_t
+{
+  std::unique_ptr<H5::H5File> h5f;
+  std::string h5f_name;
+
+  const h5_filters_t filters;
+  std::vector<float> buf; // quantised copy of the data
+
+  // the extensible datasets kept open (along with their chunk caches) while the file is open
+  std::map<std::string, H5::DataSet> series;
+
+  // the field's own chunking takes precedence, compression requires chunking
+  std::vector<hsize_t> chunk(const h5_field_t &fld, const bool required) const
+  {
+    std::vector<hsize_t> ret = fld.chunk;
+    if (ret.empty() && !filters.chunk.empty() && fld.shape.size() >= 2)
+    {
+      ret = fld.shape;
+      for (int d = 0; d < 2; ++d) ret[ret.size() - 2 + d] = filters.chunk[d];
+    }
+    if (ret.empty() && required) ret = fld.shape;
+    for (int d = 0; d < ret.size(); ++d) ret[d] = std::max(hsize_t(1), std::min(ret[d], fld.shape[d]));
+    return ret;
+  }
+
+  H5::DSetCreatPropList props(const std::vector<hsize_t> &shape, const std::vector<hsize_t> &chunk) const
+  {
+    H5::DSetCreatPropList ret;
+    if (chunk.empty() && shape.empty()) return ret; // a scalar
+    if (!chunk.empty()) ret.setChunk(chunk.size(), chunk.data());
+    if (filters.deflate > 0)
+    {
+      ret.setShuffle();
+      ret.setDeflate(filters.deflate);
+    }
+    return ret;
+  }
+
+  void put_attrs(H5::DataSet &dset, const h5_field_t &fld)
+  {
+    for (const auto &attr : fld.attrs)
+    {
+      const hsize_t n = attr.second.size();
+      dset.createAttribute(attr.first, H5::PredType::NATIVE_DOUBLE, H5::DataSpace(1, &n))
+        .write(H5::PredType::NATIVE_DOUBLE, attr.second.data());
+    }
+
+    if (!fld.unit.empty())
+    {
+      H5::StrType strtype(H5::PredType::C_S1, fld.unit.size());
+      dset.createAttribute("units", strtype, H5::DataSpace(H5S_SCALAR)).write(strtype, fld.unit);
+    }
+  }
+
+  // extending the (time, shape) dataset if needed (with the entries never written being NaN)
+  void write_record(const h5_field_t &fld, const float *data)
+  {
+    const int n_dims = fld.shape.size() + 1;
+    std::vector<hsize_t> dims({0}), max_dims({H5S_UNLIMITED});
+    dims.insert(dims.end(), fld.shape.begin(), fld.shape.end());
+    max_dims.insert(max_dims.end(), fld.shape.begin(), fld.shape.end());
+
+    auto it = series.find(fld.name);
+    if (it == series.end())
+    {
+      H5::DataSet dset;
+      if (H5Lexists(h5f->getId(), fld.name.c_str(), H5P_DEFAULT) > 0) // e.g. when restarting
+        dset = h5f->openDataSet(fld.name);
+      else
+      {
+        std::vector<hsize_t> chnk({filters.records});
+        const auto tmp = chunk(fld, true);
+        chnk.insert(chnk.end(), tmp.begin(), tmp.end());
+
+        auto prps = props(dims, chnk);
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        prps.setFillValue(H5::PredType::NATIVE_FLOAT, &nan);
+
+        dset = h5f->createDataSet(
+          fld.name, 
+          H5::PredType::NATIVE_FLOAT, 
+          H5::DataSpace(n_dims, dims.data(), max_dims.data()), 
+          prps
+        );
+        put_attrs(dset, fld);
+      }
+      it = series.emplace(fld.name, dset).first;
+    }
+    H5::DataSet &dset = it->second;
+
+    dset.getSpace().getSimpleExtentDims(dims.data());
+    if (dims[0] <= hsize_t(fld.record))
+    {
+      dims[0] = fld.record + 1;
+      dset.extend(dims.data());
+    }
+
+    std::vector<hsize_t> off(n_dims, 0), cnt(dims);
+    off[0] = fld.record;
+    cnt[0] = 1;
+    H5::DataSpace space = dset.getSpace();
+    space.selectHyperslab(H5S_SELECT_SET, cnt.data(), off.data());
+    dset.write(data, H5::PredType::NATIVE_FLOAT, H5::DataSpace(n_dims, cnt.data()), space);
+  }
+
+  // rounding (half to even) the float mantissa to keepbits bits, 
+  // the trailing zero bits making the data more compressible
+  static void bitround(std::vector<float> &data, const int keepbits)
+  {
+    const int drop = std::numeric_limits<float>::digits - 1 - keepbits;
+    if (drop <= 0) return;
+    const std::uint32_t half = std::uint32_t(1) << (drop - 1), mask = ~((std::uint32_t(1) << drop) - 1);
+    for (auto &v : data)
+    {
+      std::uint32_t b;
+      std::memcpy(&b, &v, sizeof(b));
+      if ((b & 0x7f800000) == 0x7f800000) continue; // inf or nan
+      b += half - 1 + ((b >> drop) & 1);
+      b &= mask;
+      std::memcpy(&v, &b, sizeof(b));
+    }
+  }
+
+  // -1 -> lossless
+  int keepbits(const std::string &name) const
+  {
+    int ret = -1, len = -1;
+    for (const auto &kb : filters.keepbits)
+    {
+      if (name.compare(0, kb.first.size(), kb.first) != 0 || int(kb.first.size()) <= len) continue;
+      ret = kb.second;
+      len = kb.first.size();
+    }
+    return ret;
+  }
+
+  public:
+
+  h5_writer_t(const h5_filters_t &filters = h5_filters_t()) :
+    filters(filters)
+  {}
+
+  void write(const h5_field_t &fld)
+  {
+    h5_lock_t lock(h5_mutex());
+    try
+    {
+      if (fld.create || fld.file != h5f_name)
+      {
+        close(); // the previous file first
+        const bool trunc = fld.create || !std::ifstream(fld.file).good();
+        h5f.reset(new H5::H5File(fld.file, trunc ? H5F_ACC_TRUNC : H5F_ACC_RDWR));
+        h5f_name = fld.file;
+      }
+
+      const float *data = fld.data.data();
+      const int kb = keepbits(fld.name);
+      if (kb >= 0)
+      {
+        buf = fld.data;
+        bitround(buf, kb);
+        data = buf.data();
+      }
+
+      if (fld.record < 0) 
+      {
+        H5::DataSet dset = h5f->createDataSet(
+          fld.name,
+          H5::PredType::NATIVE_FLOAT,
+          H5::DataSpace(fld.shape.size(), fld.shape.data()),
+          props(fld.shape, chunk(fld, filters.deflate > 0))
+        );
+        dset.write(data, H5::PredType::NATIVE_FLOAT);
+        put_attrs(dset, fld);
+      }
+      else write_record(fld, data);
+    }
+    catch (H5::Exception &e)
+    {
+      // H5::Exception does not derive from std::exception
+      throw std::runtime_error("HDF5 error while writing " + fld.name + " to " + fld.file + ": " + e.getDetailMsg());
+    }
+  }
+
+  // (closed explicitly, as H5::H5File's destructor does not report errors, e.g. of flushing the data)
+  void close()
+  {
+    h5_lock_t lock(h5_mutex());
+    series.clear();
+    std::unique_ptr<H5::H5File> tmp(std::move(h5f));
+    const std::string name(h5f_name);
+    h5f_name.clear();
+    if (!tmp) return;
+    try
+    {
+      tmp->close();
+    }
+    catch (H5::Exception &e)
+    {
+      throw std::runtime_error("HDF5 error while closing " + name + ": " + e.getDetailMsg());
+    }
+  }
+
+  ~h5_writer_t()
+  {
+    try { close(); } catch (...) {} // see close() for reporting errors
+  }
+};
+
+// writer thread fed through a bounded queue; the queue depth is expressed
+// in files (i.e. output steps), push() blocks if the writer falls behind;
+// the records are recycled to avoid reallocating the staging buffers
+class h5_async_writer_t
+{
+  const int depth;
+
+  std::deque<std::unique_ptr<h5_field_t>> queue;
+  std::vector<std::unique_ptr<h5_field_t>> pool;
+  std::map<std::string, int> pending; // number of queued or being-written fields per file
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool done = false, flush_req = false;
+  std::exception_ptr error;
+
+  h5_writer_t writer;
+  std::thread thread;
+
+  void loop()
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+      cv.wait(lock, [&]{ return done || flush_req || !queue.empty(); });
+
+      // nothing left to write: closing the file (i.e. getting it to disk); not holding
+      // mtx while waiting for h5_mutex() (held by rank 0 possibly blocked in push())
+      if (queue.empty())
+      {
+        lock.unlock();
+        std::exception_ptr failed;
+        try
+        {
+          writer.close();
+        }
+        catch (...)
+        {
+          failed = std::current_exception();
+        }
+        lock.lock();
+        if (failed && !error) error = failed;
+        if (!queue.empty()) continue; // pushed in the meantime
+        if (done) break;
+        flush_req = false;
+        cv.notify_all();
+        continue;
+      }
+
+      std::unique_ptr<h5_field_t> fld(std::move(queue.front()));
+      queue.pop_front();
+      const bool failed = bool(error); // skipping the rest after an error
+
+      lock.unlock();
+      try
+      {
+        if (!failed) writer.write(*fld);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> guard(mtx);
+        error = std::current_exception();
+      }
+      lock.lock();
+
+      if (--pending[fld->file] == 0) pending.erase(fld->file);
+      pool.push_back(std::move(fld));
+      cv.notify_all();
+    }
+  }
+
+  void rethrow()
+  {
+    if (!error) return;
+    std::exception_ptr tmp;
+    std::swap(tmp, error);
+    std::rethrow_exception(tmp);
+  }
+
+  static int check_depth(const int depth)
+  {
+    if (depth < 1) throw std::invalid_argument("output queue depth must be positive");
+    return depth;
+  }
+
+  public:
+
+  h5_async_writer_t(const int depth, const h5_filters_t &filters = h5_filters_t()) :
+    depth(check_depth(depth)),
+    writer(filters),
+    thread(&h5_async_writer_t::loop, this)
+  {}
+
+  // a (possibly recycled) record to be filled in and passed to push()
+  std::unique_ptr<h5_field_t> acquire()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (pool.empty()) return std::unique_ptr<h5_field_t>(new h5_field_t());
+    std::unique_ptr<h5_field_t> ret(std::move(pool.back()));
+    pool.pop_back();
+    return ret;
+  }
+
+  void push(std::unique_ptr<h5_field_t> fld)
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    rethrow();
+
+    // back-pressure: not starting another file if depth files are pending
+    cv.wait(lock, [&]{ return pending.count(fld->file) != 0 || int(pending.size()) < depth; });
+
+    pending[fld->file]++;
+    queue.push_back(std::move(fld));
+    cv.notify_all();
+  }
+
+  // blocks until everything queued so far is written and the files are closed
+  void flush()
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [&]{ return pending.empty(); });
+    flush_req = true;
+    cv.notify_all();
+    cv.wait(lock, [&]{ return !flush_req; });
+    rethrow();
+  }
+
+  // note: errors are reported by push() and flush(), i.e. the last ones only if 
+  // flushed before destruction (see kin_cloud_2d_common::finish_output())
+  ~h5_async_writer_t()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      done = true;
+    }
+    cv.notify_all();
+    thread.join();
+  }
+};
@@ -0,0 +1,32 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+// 64-bit FNV-1a hash (not cryptographic, used for naming cached files)
+inline std::uint64_t fnv1a(const std::string &str)
+{
+  std::uint64_t h = 14695981039346656037ull;
+  for (const unsigned char c : str)
+  {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+inline std::string fnv1a_hex(const std::string &str)
+{
+  std::ostringstream tmp;
+  tmp << std::hex << std::setw(16) << std::setfill('0') << fnv1a(str);
+  return tmp.str();
+}
@@ -5,9 +5,7 @@
  * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
  */
 
-#include <libmpdata++/bcond/cyclic_2d.hpp>
-#include <libmpdata++/bcond/open_2d.hpp>
-#include <libmpdata++/concurr/boost_thread.hpp> // not to conflict with OpenMP used via Thrust in libcloudph++
+#include "concurr.hpp" // boost_thread by default, not to conflict with OpenMP used via Thrust in libcloudph++
 
 #include "icmw8_case1.hpp" // 8th ICMW case 1 by Wojciech Grabowski)
 namespace setup = icmw8_case1;
@@ -16,14 +14,36 @@ namespace setup = icmw8_case1;
 #include "opts_blk_2m.hpp"
 #include "opts_lgrngn.hpp"
 
+#include "ct_params.hpp"
+
 // exception handling
 #include <boost/exception/all.hpp>
 
 #include "panic.hpp"
+#include "hash.hpp"
+
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <set>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
 
-// model run logic - the same for any microphysics
-template <class solver_t>
-void run(int nx, int nz, int nt, const std::string &outdir, const int &outfreq, int spinup)
+// model run logic - the same for any microphysics and concurrency backend
+template <class solver_t, template <class> class concurr_tt>
+void run(
+  int nx, int nz, int nt, const std::string &outdir, const int &outfreq, int spinup, 
+  const po::variables_map &vm, 
+  const std::set<std::string> &spinup_indep // options that do not influence the spinup
+)
 {
   // instantiation of structure containing simulation parameters
   typename solver_t::rt_params_t p;
@@ -33,36 +53,230 @@ void run(int nx, int nz, int nt, const std::string &outdir, const int &outfreq,
   p.outdir = outdir;
   p.outfreq = outfreq;
   p.spinup = spinup;
+  if (vm["timing"].as<bool>()) p.timing.reset(new timing_t(outdir, long(nx) * nz));
+  p.out_async = vm["out_async"].as<bool>();
+  p.out_queue = vm["out_queue"].as<int>();
+  p.out_filters = out_filters(vm);
+  const std::string out_layout = vm["out_layout"].as<std::string>();
+  if (out_layout != "timestep" && out_layout != "series") BOOST_THROW_EXCEPTION(po::validation_error(
+    po::validation_error::invalid_option_value, "out_layout", out_layout
+  ));
+  p.out_series = out_layout == "series";
+  p.out_sched = out_sched(vm, outfreq);
+  p.reductions = reductions(vm);
+
+  // relaxation terms
+  p.relax_tau = relax_tau(vm);
+  if (!p.relax_tau.empty()) p.level_sums.reset(new level_sums_t());
+
+  // checkpointing
+  p.checkpoint_freq = vm["checkpoint_freq"].as<int>();
+  if (vm.count("restart")) p.restart = vm["restart"].as<std::string>();
+
   setup::setopts(p, nx, nz);
   setopts_micro<solver_t>(p, nx, nz, nt);
 
-  // solver instantiation
-  concurr::boost_thread<solver_t, 
-    bcond::cyclic, bcond::cyclic,
-    bcond::open,   bcond::open 
-  > slv(p);
+  // spinup cache: the state at the end of spinup is looked up by a hash of all options
+  // that can influence it (and saved under that name if not found); 
+  // note: vm_all is filled when parsing the micro options in setopts_micro()
+  if (vm.count("spinup_cache") && spinup > 0 && spinup < nt)
+  {
+    const std::string 
+      key = opts_key(vm_all, spinup_indep) + "sizeof(real_t)=" + std::to_string(sizeof(typename solver_t::real_t)) + ";",
+      dir = vm["spinup_cache"].as<std::string>(),
+      file = dir + "/spinup_" + fnv1a_hex(key) + ".h5";
 
-  // initial condition
-  setup::intcond(slv);
+    std::string cached_key;
+    if (std::ifstream(file) && std::getline(std::ifstream(file + ".key"), cached_key) && cached_key == key)
+    {
+      std::cerr << "info: starting from the cached spinup state: " << file << std::endl;
+      p.restart = file;
+    }
+    else
+    {
+      boost::filesystem::create_directories(dir);
+      p.spinup_save = file;
+      p.spinup_key = key;
+    }
+  }
+
+  if (!p.restart.empty())
+  {
+    checkpoint_t chkp(p.restart, false);
+    p.restart_timestep = chkp.get_attr("timestep");
+    p.restart_rain = chkp.get_attr("rain");
+    if (p.restart_timestep >= nt) BOOST_THROW_EXCEPTION(po::validation_error(
+      po::validation_error::invalid_option_value, "restart", p.restart
+    ));
+  }
+
+  // the thread budget: libmpdata++'s thread count is taken from OMP_NUM_THREADS (set here if 
+  // given with --threads_adv), the particles' OpenMP team being a separate one with --async;
+  // the OpenMP team sizes are set explicitly as the runtime may have read the variable already
+  const int n_memb = vm["ensemble"].as<int>(), n_cpu = allowed_cpus().size(); // the cores available to the process
+  if (vm["threads_adv"].as<int>() > 0) setenv("OMP_NUM_THREADS", std::to_string(vm["threads_adv"].as<int>()).c_str(), 1);
+  p.threads.adv = std::getenv("OMP_NUM_THREADS") ? std::max(1, std::atoi(std::getenv("OMP_NUM_THREADS"))) : n_cpu;
+  const std::string concurr = vm["concurr"].as<std::string>();
+  if (concurr == "serial") p.threads.adv = 1;
+#if defined(_OPENMP)
+  omp_set_num_threads(p.threads.adv); // --concurr=openmp
+#endif
+  bool async = false;
+  if (vm_all.count("backend") && vm_all["backend"].as<std::string>() == "OpenMP")
+  {
+    const int n = vm_all["threads_micro"].as<int>();
+    p.threads.micro = n > 0 ? n : p.threads.adv; // set with omp_set_num_threads() in kin_cloud_2d_lgrngn::hook_ante_loop()
+    async = vm_all["async"].as<bool>() && !vm_all["async"].defaulted(); // as in setopts_micro()
 
-  // setup panic pointer and the signal handler
-  panic = slv.panic_ptr();
+    // libmpdata++'s ranks being OpenMP threads, the particles' team would be a nested one (i.e. serial)
+    if (concurr == "openmp" && !async) BOOST_THROW_EXCEPTION(po::validation_error(
+      po::validation_error::invalid_option_value, "concurr", "openmp (not supported with --backend=OpenMP unless --async=1)"
+    ));
+  }
+  p.threads.pin = vm["pin"].as<std::string>();
+  const int budget = n_memb * (async ? p.threads.adv + p.threads.micro : std::max(p.threads.adv, p.threads.micro));
+  std::cerr << "info: " << p.threads.str() << (n_memb > 1 ? " per ensemble member" : "") << std::endl;
+  if (budget > n_cpu) 
+    std::cerr << "warning: " << budget << " threads running concurrently on " << n_cpu << " cores (oversubscribed)" << std::endl;
+
+  // ensemble members: concurrent independent solvers (each with its own arrays, thread team and output directory)
+  using concurr_t = concurr_tt<solver_t>;
+  std::vector<std::unique_ptr<concurr_t>> slvs;
+  for (int m = 0; m < n_memb; ++m)
+  {
+    typename solver_t::rt_params_t pm(p);
+    try { pm.threads.place(m, n_memb); }
+    catch (std::invalid_argument &e) { BOOST_THROW_EXCEPTION(po::validation_error(
+      po::validation_error::invalid_option_value, "pin", p.threads.pin + " (" + e.what() + ")"
+    )); }
+    if (n_memb > 1)
+    {
+      std::ostringstream tmp;
+      tmp << outdir << "/member" << std::setw(3) << std::setfill('0') << m;
+      pm.outdir = tmp.str();
+      boost::filesystem::create_directories(pm.outdir);
+      if (p.timing) pm.timing.reset(new timing_t(pm.outdir, long(nx) * nz));
+      if (p.reductions) pm.reductions.reset(new reductions_t(p.reductions->vars, p.reductions->freq));
+      if (p.level_sums) pm.level_sums.reset(new level_sums_t());
+    }
+
+    // solver instantiation
+    slvs.emplace_back(new concurr_t(pm));
+  }
+
+  // initial condition (computed once, copied to the other members)
+  setup::intcond(*slvs[0]);
+  for (int m = 1; m < n_memb; ++m)
+  {
+    for (int e = 0; e < solver_t::n_eqns; ++e) slvs[m]->advectee(e) = slvs[0]->advectee(e);
+    for (int d = 0; d < 2; ++d) slvs[m]->advector(d) = slvs[0]->advector(d);
+    slvs[m]->g_factor() = slvs[0]->g_factor();
+
+    // optional perturbation of th (member 0 being the unperturbed one)
+    const typename solver_t::real_t amp = vm["ensemble_pert"].as<double>();
+    if (amp != 0)
+    {
+      std::mt19937 gen(m);
+      std::uniform_real_distribution<typename solver_t::real_t> dist(-amp, amp);
+      auto th = slvs[m]->advectee(solver_t::ix::th);
+      for (auto it = th.begin(); it != th.end(); ++it) *it += dist(gen);
+    }
+  }
+
+  // setup panic pointers and the signal handler
+  for (auto &slv : slvs) panic.push_back(slv->panic_ptr());
   set_sigaction();
  
-  // timestepping
-  slv.advance(nt);
+  // timestepping (the remaining steps if restarting): libmpdata++ computes the loop bound
+  // as nt plus the timestep counter before calling hook_ante_loop(), i.e. while it is still 0,
+  // the counter being set to restart_timestep only there (see load_checkpoint()), hence nt
+  // is the bound to pass to get the run ending at timestep nt
+  if (n_memb == 1) 
+  {
+    slvs[0]->advance(nt);
+    return;
+  }
+
+  // members advanced concurrently, each by its own thread team
+  // (their HDF5 calls serialised, see h5_mutex() in h5_writer.hpp)
+  std::vector<std::thread> thrds;
+  std::vector<std::exception_ptr> errors(n_memb);
+  for (int m = 0; m < n_memb; ++m)
+    thrds.emplace_back([&, m]{
+      try { slvs[m]->advance(nt); }
+      catch (...) { errors[m] = std::current_exception(); }
+    });
+  for (auto &thrd : thrds) thrd.join();
+  for (auto &error : errors) if (error) std::rethrow_exception(error);
+}
+
+// instantiating the solver with the concurrency backend chosen at run time (see concurr.hpp)
+template <class solver_t, typename... args_t>
+void run_concurr(const std::string &concurr, const args_t&... args)
+{
+  if (concurr == "boost_thread")
+    run<solver_t, concurr_boost_thread>(args...);
+#if defined(ICICLE_ALL_CONCURR)
+  else
+  if (concurr == "openmp")
+    run<solver_t, concurr_openmp>(args...);
+  else
+  if (concurr == "serial")
+    run<solver_t, concurr_serial>(args...);
+#  if defined(ICICLE_CXX11_THREAD)
+  else
+  if (concurr == "cxx11_thread")
+    run<solver_t, concurr_cxx11_thread>(args...);
+#  endif
+#endif
+  else BOOST_THROW_EXCEPTION(
+    po::validation_error(
+      po::validation_error::invalid_option_value, "concurr", concurr
+    )
+  );
 }
 
+// the solvers in which acc_t differs from real_t in any computation, i.e. the ones for 
+// which --precision=mixed is instantiated (blk_1m with its SIMD saturation adjustment)
+template <template <class> class solver_t>
+struct uses_acc_t : std::false_type {};
+
+template <>
+struct uses_acc_t<kin_cloud_2d_blk_1m> : std::true_type {};
+
+template <template <class> class solver_t, template <typename, typename> class ct_params_t, typename... args_t>
+void run_mixed(std::true_type, const std::string &concurr, const args_t&... args)
+{
+  run_concurr<solver_t<ct_params_t<float, double>>>(concurr, args...);
+}
 
-// libmpdata++'s compile-time parameters
-struct ct_params_common : ct_params_default_t
+template <template <class> class solver_t, template <typename, typename> class ct_params_t, typename... args_t>
+void run_mixed(std::false_type, const std::string &, const args_t&...)
 {
-  using real_t = setup::real_t;
-  enum { n_dims = 2 };
-  enum { opts = opts::nug | opts::fct }; 
-  enum { rhs_scheme = solvers::euler_b };
-};
+  BOOST_THROW_EXCEPTION(po::validation_error(
+    po::validation_error::invalid_option_value, "precision", "mixed (supported with --micro=blk_1m only)"
+  ));
+}
 
+// instantiating the solver with the precision chosen at run time
+// (libcloudph++ works in the precision of the model state)
+template <template <class> class solver_t, template <typename, typename> class ct_params_t, typename... args_t>
+void run_prec(const std::string &precision, const std::string &concurr, const args_t&... args)
+{
+  if (precision == "float")
+    run_concurr<solver_t<ct_params_t<float, float>>>(concurr, args...);
+  else
+  if (precision == "double")
+    run_concurr<solver_t<ct_params_t<double, double>>>(concurr, args...);
+  else
+  if (precision == "mixed")
+    run_mixed<solver_t, ct_params_t>(uses_acc_t<solver_t>(), concurr, args...);
+  else BOOST_THROW_EXCEPTION(
+    po::validation_error(
+      po::validation_error::invalid_option_value, "precision", precision
+    )
+  );
+}
 
 // all starts here with handling general options 
 int main(int argc, char** argv)
@@ -82,6 +296,26 @@ int main(int argc, char** argv)
       ("outdir", po::value<std::string>(), "output file name (netCDF-compatible HDF5)")
       ("outfreq", po::value<int>(), "output rate (timestep interval)")
       ("spinup", po::value<int>()->default_value(2400) , "number of initial timesteps during which rain formation is to be turned off")
+      ("timing", po::value<bool>()->default_value(false) , "per-phase wall-clock timers written to outdir/timing.csv (1=on, 0=off)")
+      ("out_async", po::value<bool>()->default_value(false) , "output written by a separate thread while the solver keeps stepping (1=on, 0=off)")
+      ("out_queue", po::value<int>()->default_value(2) , "max. number of output steps waiting to be written with --out_async")
+      ("out_layout", po::value<std::string>()->default_value("timestep") , "output files: timestep (outdir/timestepNNNNNNNNNN.h5 per output step) or series (outdir/series.h5 with an extensible time axis, chunked along it)")
+      ("out_sched", po::value<std::string>()->default_value("") , "per-variable output intervals (multiples of outfreq, 0=never) by variable-name prefix, e.g. rc:10,rr:10,rw_:600,*:60 (other variables every outfreq timesteps)")
+      ("out_chunk", po::value<std::string>(), "chunk extent X,Z of the output fields (default: contiguous fields, or one chunk per field if compressed)")
+      ("out_deflate", po::value<int>()->default_value(0) , "gzip level of the output compression, preceded by byte shuffling (0=off, 1..9)")
+      ("out_keepbits", po::value<std::string>()->default_value("") , "lossy output: float mantissa bits kept (0..22) per field-name prefix, e.g. rc:8,rr:8,rw_:10,*:16 (other fields lossless)")
+      ("relax", po::value<std::string>()->default_value("") , "relaxation of the horizontal th and rv anomalies: timescale profile as height [m] : timescale [s] points in ascending height, e.g. 0:3600,1500:600 (linearly interpolated, constant outside; empty=off)")
+      ("diag", po::value<std::string>()->default_value("") , "in-situ reductions written to outdir/diag.h5, any of (comma-separated): lwp, rwp (domain-mean cloud and rain water paths), cloud_cover (fraction of columns with rc > 1e-5 kg kg-1), precip (domain-mean surface precipitation flux), smax (max. supersaturation), prof (domain-mean profiles of th, rv, rc, rr)")
+      ("diag_freq", po::value<int>()->default_value(1) , "timestep interval of the in-situ reductions")
+      ("checkpoint_freq", po::value<int>()->default_value(0) , "model state written to outdir/checkpointNNNNNNNNNN.h5 every that many timesteps (0=off, bulk schemes only)")
+      ("restart", po::value<std::string>(), "checkpoint file to resume the simulation from (bulk schemes only)")
+      ("spinup_cache", po::value<std::string>(), "directory with model states at the end of spinup reused among runs with the same spinup-relevant options (bulk schemes only)")
+      ("threads_adv", po::value<int>()->default_value(0) , "advection threads (per ensemble member; 0 -> OMP_NUM_THREADS or, if not set, all cores)")
+      ("pin", po::value<std::string>()->default_value("none") , "pinning of the advection threads (one per core) and of the particle microphysics (--threads_micro, confined to its cores): compact (consecutive cores), scatter (spread over all cores), none, or a list of cores, e.g. 0,2,4,6 (the advection threads' ones first, split into consecutive slices among the ensemble members); out of the cores the process is allowed to run on")
+      ("concurr", po::value<std::string>()->default_value("boost_thread") , "concurrency backend of the solver: boost_thread or, if built with -DICICLE_ALL_CONCURR=ON, also openmp, serial (a single thread) and, if supported by libmpdata++, cxx11_thread (see tests/perf/concurr.cpp for a comparison)")
+      ("ensemble", po::value<int>()->default_value(1) , "number of ensemble members run concurrently as independent solvers in one process (no fields shared nor batched among them; output in outdir/memberNNN, threads per member set with OMP_NUM_THREADS)")
+      ("ensemble_pert", po::value<double>()->default_value(0) , "amplitude [K] of white-noise th perturbations of the initial condition of members other than the first one")
+      ("precision", po::value<std::string>()->default_value("float") , "floating-point type of the model state: float, double or mixed (float state, saturation adjustment iterated in double; --micro=blk_1m with --adj=simd or simd_skip only)")
       ("help", "produce a help message (see also --micro X --help)")
     ;
     po::variables_map vm;
@@ -117,48 +351,94 @@ int main(int argc, char** argv)
 
     // handling the "micro" option
     std::string micro = vm["micro"].as<std::string>();
-    if (micro == "blk_1m")
+
+    // libcloudph++ offers no access to the super-droplet state
+    if (micro == "lgrngn")
     {
-      // libmpdata++'s compile-time parameters
-      struct ct_params_t : ct_params_common
-      {
-	enum { n_eqns = 4 };
-        struct ix { enum {th, rv, rc, rr}; };
-        enum { hint_norhs = opts::bit(ix::th) | opts::bit(ix::rv) }; // only through adjustments
-      };
-      run<kin_cloud_2d_blk_1m<ct_params_t>>(nx, nz, nt, outdir, outfreq, spinup);
+      if (vm["checkpoint_freq"].as<int>() != 0) BOOST_THROW_EXCEPTION(po::validation_error(
+        po::validation_error::invalid_option_value, "checkpoint_freq", "(not supported with --micro=lgrngn)"
+      ));
+      for (auto &opt : {"restart", "spinup_cache"})
+        if (vm.count(opt)) BOOST_THROW_EXCEPTION(po::validation_error(
+          po::validation_error::invalid_option_value, opt, "(not supported with --micro=lgrngn)"
+        ));
+
+      // rc and rr not being a part of the model state
+      auto red = reductions(vm);
+      for (auto &var : {"lwp", "rwp", "cloud_cover", "precip"})
+        if (red && red->on(var)) BOOST_THROW_EXCEPTION(po::validation_error(
+          po::validation_error::invalid_option_value, "diag", std::string(var) + " (not supported with --micro=lgrngn)"
+        ));
     }
-    else
-    if (micro == "blk_2m")
+    if (vm.count("restart") && vm.count("spinup_cache")) BOOST_THROW_EXCEPTION(po::validation_error(
+      po::validation_error::invalid_option_value, "spinup_cache", "(cannot be combined with --restart)"
+    ));
+
+    // handling the ensemble options
+    const int n_memb = vm["ensemble"].as<int>();
+    if (n_memb < 1) BOOST_THROW_EXCEPTION(po::validation_error(
+      po::validation_error::invalid_option_value, "ensemble", std::to_string(n_memb)
+    ));
+    if (n_memb > 1) 
     {
-      struct ct_params_t : ct_params_common
-      {
-	enum { n_eqns = 6 };
-	struct ix { enum {th, rv, rc, rr, nc, nr}; }; 
-
-        static constexpr int hint_scale(const int &e) 
-	{
-	  return 
-            e == ix::nc ?  24 : // 1.7e7
-            e == ix::nr ?  17 : // 1.3e5 
-            e == ix::rc ? -14 : // 1.6e4
-            e == ix::rr ? -14 : // 1.6e4
-            0;
-	}
-      };
-      run<kin_cloud_2d_blk_2m<ct_params_t>>(nx, nz, nt, outdir, outfreq, spinup);
+      for (auto &opt : {"restart", "spinup_cache"})
+        if (vm.count(opt)) BOOST_THROW_EXCEPTION(po::validation_error(
+          po::validation_error::invalid_option_value, opt, "(not supported with --ensemble)"
+        ));
+
+      // libmpdata++'s thread count is taken from OMP_NUM_THREADS, 
+      // by default the cores are shared among the members
+      if (std::getenv("OMP_NUM_THREADS") == NULL)
+        setenv("OMP_NUM_THREADS", std::to_string(std::max(1, int(allowed_cpus().size()) / n_memb)).c_str(), 1);
+    }
+
+    // handling the thread options
+    if (vm["threads_adv"].as<int>() < 0) BOOST_THROW_EXCEPTION(po::validation_error(
+      po::validation_error::invalid_option_value, "threads_adv", std::to_string(vm["threads_adv"].as<int>())
+    ));
+    {
+      const std::string pin = vm["pin"].as<std::string>();
+      if (pin != "compact" && pin != "scatter" && pin != "none" && pin.find_first_not_of("0123456789,") != std::string::npos) 
+        BOOST_THROW_EXCEPTION(po::validation_error(po::validation_error::invalid_option_value, "pin", pin));
     }
-    else 
-    if (micro == "lgrngn")
     {
-      struct ct_params_t : ct_params_common
-      {
-	enum { n_eqns = 2 };
-	struct ix { enum {th, rv}; };
-        enum { hint_norhs = opts::bit(ix::th) | opts::bit(ix::rv) }; // only through adjustments
-      };
-      run<kin_cloud_2d_lgrngn<ct_params_t>>(nx, nz, nt, outdir, outfreq, spinup);
+      const std::string concurr = vm["concurr"].as<std::string>();
+      const auto &names = concurr_names();
+      if (std::find(names.begin(), names.end(), concurr) == names.end()) 
+        BOOST_THROW_EXCEPTION(po::validation_error(po::validation_error::invalid_option_value, "concurr", concurr));
     }
+
+    // options with no influence on the state at the end of spinup ...
+    std::set<std::string> spinup_indep({
+      "nt", "outdir", "outfreq", "timing", "out_async", "out_queue", "out_layout", "out_sched", "out_chunk", "out_deflate", "out_keepbits",
+      "diag", "diag_freq", "checkpoint_freq", "restart", "spinup_cache", 
+      "ensemble", "ensemble_pert", "threads_adv", "pin", "concurr", "help"
+    });
+    // ... including the processes with no effect if there is no rain (see set_rain()); 
+    // not conv and acnv: turned off, they mean no spinup at all (see hook_ante_loop())
+    if (micro == "blk_1m") spinup_indep.insert({"accr", "sedi", "revp"});
+    if (micro == "blk_2m") spinup_indep.insert({"accr", "sedi"});
+
+    // handling the "precision" and "concurr" options (see run_prec() and run_concurr())
+    const std::string precision = vm["precision"].as<std::string>(), concurr = vm["concurr"].as<std::string>();
+
+    // th and rv have no rhs in blk_1m and lgrngn unless the relaxation terms are on (see ct_params.hpp)
+    const bool relax = !relax_tau(vm).empty();
+
+    if (micro == "blk_1m" && !relax)
+      run_prec<kin_cloud_2d_blk_1m, ct_params_blk_1m>(precision, concurr, nx, nz, nt, outdir, outfreq, spinup, vm, spinup_indep);
+    else
+    if (micro == "blk_1m" && relax)
+      run_prec<kin_cloud_2d_blk_1m, ct_params_blk_1m_relax>(precision, concurr, nx, nz, nt, outdir, outfreq, spinup, vm, spinup_indep);
+    else
+    if (micro == "blk_2m")
+      run_prec<kin_cloud_2d_blk_2m, ct_params_blk_2m>(precision, concurr, nx, nz, nt, outdir, outfreq, spinup, vm, spinup_indep);
+    else 
+    if (micro == "lgrngn" && !relax)
+      run_prec<kin_cloud_2d_lgrngn, ct_params_lgrngn>(precision, concurr, nx, nz, nt, outdir, outfreq, spinup, vm, spinup_indep);
+    else 
+    if (micro == "lgrngn" && relax)
+      run_prec<kin_cloud_2d_lgrngn, ct_params_lgrngn_relax>(precision, concurr, nx, nz, nt, outdir, outfreq, spinup, vm, spinup_indep);
     else BOOST_THROW_EXCEPTION(
       po::validation_error(
         po::validation_error::invalid_option_value, micro, "micro" 
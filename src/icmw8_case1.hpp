@@ -13,12 +13,10 @@
 #include <boost/math/special_functions/sin_pi.hpp>
 #include <boost/math/special_functions/cos_pi.hpp>
 
-// TODO: relaxation terms still missing
-
 // 8th ICMW case 1 by Wojciech Grabowski)
 namespace icmw8_case1
 {
-  using real_t = float; //double;
+  using real_t = float; // the precision of the constants below and the default one of the solvers (see --precision)
 
   namespace hydrostatic = libcloudphxx::common::hydrostatic;
   namespace theta_std = libcloudphxx::common::theta_std;
@@ -60,16 +58,23 @@ namespace icmw8_case1
   const quantity<si::dimensionless, real_t> chem_b = .55; //ammonium sulphate //chem_b = 1.33; // sodium chloride
 
   // density profile as a function of altitude
+  template <typename T = real_t>
   struct rhod
   {
-    real_t operator()(real_t z) const
+    T operator()(T z) const
     {
-      quantity<si::pressure, real_t> p = hydrostatic::p(
-	z * si::metres, th_0, rv_0, z_0, p_0
+      quantity<si::pressure, T> p = hydrostatic::p(
+	z * si::metres, 
+        quantity<si::temperature, T>(th_0), 
+        quantity<si::dimensionless, T>(rv_0), 
+        quantity<si::length, T>(z_0), 
+        quantity<si::pressure, T>(p_0)
       );
       
-      quantity<si::mass_density, real_t> rhod = theta_std::rhod(
-	p, th_0, rv_0
+      quantity<si::mass_density, T> rhod = theta_std::rhod(
+	p, 
+        quantity<si::temperature, T>(th_0), 
+        quantity<si::dimensionless, T>(rv_0)
       );
 
       return rhod / si::kilograms * si::cubic_metres;
@@ -84,12 +89,16 @@ namespace icmw8_case1
   /// (similar to eq. 2 in @copydetails Rasinski_et_al_2011, Atmos. Res. 102)
   /// @arg xX = x / X
   /// @arg zZ = z / Z
-  real_t psi(real_t xX, real_t zZ) // for computing a numerical derivative
+  template <typename T = real_t>
+  struct psi // for computing a numerical derivative
   {
-    using namespace boost::math;
-    return - sin_pi(zZ) * cos_pi(2 * xX);
-  }
-  BZ_DECLARE_FUNCTION2_RET(psi, real_t)
+    T operator()(T xX, T zZ) const
+    {
+      using namespace boost::math;
+      return - sin_pi(zZ) * cos_pi(2 * xX);
+    }
+    BZ_DECLARE_FUNCTOR2(psi);
+  };
 
   real_t dpsi_dz(real_t xX, real_t zZ)
   {
@@ -119,6 +128,7 @@ namespace icmw8_case1
   void intcond(concurr_t &solver)
   {
     using ix = typename concurr_t::solver_t::ix;
+    using real_t = typename concurr_t::solver_t::real_t; // shadowing the namespace-level one
 
     // helper ondex placeholders
     blitz::firstIndex i;
@@ -138,14 +148,14 @@ namespace icmw8_case1
     solver.advectee(ix::rv) = real_t(rv_0);
 
     // density profile
-    solver.g_factor() = rhod()(j * dz);
+    solver.g_factor() = rhod<real_t>()(j * dz);
 
     // momentum field obtained by numerically differentiating a stream function
     solver.advector(x) = - A * 
     // numerical derivative (see note on div values below)
     (
-      psi((i+.5)/(nx-1), (j+.5)/(nz-1))- 
-      psi((i+.5)/(nx-1), (j-.5)/(nz-1))  
+      psi<real_t>()((i+.5)/(nx-1), (j+.5)/(nz-1))- 
+      psi<real_t>()((i+.5)/(nx-1), (j-.5)/(nz-1))  
     ) / dz                       
     // analytical derivative (ditto)
     //dpsi_dz((i+.5)/real_t(nx-1), j/real_t(nz-1))
@@ -154,8 +164,8 @@ namespace icmw8_case1
     solver.advector(z) = A * 
     // numerical derivative (max(abs(div)) ~ 5e-10)
     (
-      psi((i+.5)/(nx-1), (j+.5)/(nz-1)) - 
-      psi((i-.5)/(nx-1), (j+.5)/(nz-1))   
+      psi<real_t>()((i+.5)/(nx-1), (j+.5)/(nz-1)) - 
+      psi<real_t>()((i-.5)/(nx-1), (j+.5)/(nz-1))   
     ) / dx 
     // analytical derivative (max(abs(div)) ~ 3e-5)
     //dpsi_dx(i/real_t(nx-1), (j+.5)/real_t(nz-1))
@@ -2,8 +2,10 @@
 
 #include <libcloudph++/blk_1m/options.hpp>
 #include <libcloudph++/blk_1m/adj_cellwise.hpp>
-#include <libcloudph++/blk_1m/rhs_cellwise.hpp>
-#include <libcloudph++/blk_1m/rhs_columnwise.hpp>
+
+#include "adj_simd.hpp"
+
+#include "rhs_fused.hpp"
 
 // @brief a minimalistic kinematic cloud model with bulk microphysics
 //        built on top of the mpdata_2d solver (by extending it with
@@ -16,24 +18,48 @@ class kin_cloud_2d_blk_1m : public kin_cloud_2d_common<ct_params_t>
   public:
   using ix = typename ct_params_t::ix; // TODO: it's now in solver_common - is it needed here?
   using real_t = typename ct_params_t::real_t;
+  using acc_t = typename ct_params_t::acc_t;
   private:
 
   void condevap()
   {
-    auto 
-      th   = this->state(ix::th)(this->ijk), // potential temperature
-      rv   = this->state(ix::rv)(this->ijk), // water vapour mixing ratio
-      rc   = this->state(ix::rc)(this->ijk), // cloud water mixing ratio
-      rr   = this->state(ix::rr)(this->ijk); // rain water mixing ratio
-    auto const
-      rhod = (*this->mem->G)(this->ijk);
-      
-    libcloudphxx::blk_1m::adj_cellwise<real_t>( 
-      opts, rhod, th, rv, rc, rr, this->dt
-    );
-    this->mem->barrier(); 
+    scoped_timer tmr(this->timers(), "condevap");
+
+    if (adj == adj_t::scalar)
+    {
+      auto 
+	th   = this->state(ix::th)(this->ijk), // potential temperature
+	rv   = this->state(ix::rv)(this->ijk), // water vapour mixing ratio
+	rc   = this->state(ix::rc)(this->ijk), // cloud water mixing ratio
+	rr   = this->state(ix::rr)(this->ijk); // rain water mixing ratio
+      auto const
+	rhod = (*this->mem->G)(this->ijk);
+	
+      libcloudphxx::blk_1m::adj_cellwise<real_t>( 
+	opts, rhod, th, rv, rc, rr, this->dt
+      );
+    }
+    else
+    {
+      // column by column, the columns being contiguous in memory
+      assert(this->state(ix::th).stride(1) == 1 && this->mem->G->stride(1) == 1);
+      const int j0 = this->j.first(), nz = this->j.last() - j0 + 1;
+      for (int i = this->i.first(); i <= this->i.last(); ++i)
+	adj_simd.adj(opts, 
+	  &(*this->mem->G)(i, j0),
+	  &this->state(ix::th)(i, j0),
+	  &this->state(ix::rv)(i, j0),
+	  &this->state(ix::rc)(i, j0),
+	  &this->state(ix::rr)(i, j0),
+	  nz, adj == adj_t::simd_skip
+	);
+    }
+    this->timed_barrier(); 
   }
 
+  adj_t adj;
+  adj_simd_t<real_t, acc_t> adj_simd; // with per-thread packing buffers
+
   void zero_if_uninitialised(int e)
   {
     if (!finite(sum(this->state(e)(this->ijk)))) 
@@ -43,7 +69,33 @@ class kin_cloud_2d_blk_1m : public kin_cloud_2d_common<ct_params_t>
   protected:
 
   bool get_rain() { return opts.conv; }
-  void set_rain(bool val) { opts.conv = val; };
+  void set_rain(bool val) 
+  { 
+    opts.conv = val; 
+    select_rhs();
+  };
+
+  void select_rhs()
+  {
+    rhs_fun = rhs_select<0, 1, 2, 3, 4, 5, 6, 7>(procs_blk_1m::mask(opts)); // all the combinations
+  }
+
+  // for the in-situ reductions
+  const typename parent_t::arr_t *cloud_water() { return &this->state(ix::rc); }
+  const typename parent_t::arr_t *rain_water() { return &this->state(ix::rr); }
+
+  bool rain_sedi(typename parent_t::arr_t &dot_rr, typename parent_t::arr_t &) 
+  {
+    dot_rr = 0;
+    if (opts.sedi) rhs_fused_blk_1m<procs_blk_1m::sedi>( // note: dot_rc not touched
+      opts,
+      dot_rr, dot_rr,
+      *this->mem->G, this->state(ix::rc), this->state(ix::rr),
+      this->i, this->j,
+      this->dz
+    );
+    return true;
+  }
 
   // deals with initial supersaturation
   void hook_ante_loop(int nt)
@@ -64,34 +116,48 @@ class kin_cloud_2d_blk_1m : public kin_cloud_2d_common<ct_params_t>
     const typename parent_t::real_t &dt,
     const int &at 
   ) {
+    scoped_timer tmr(this->timers(), "update_rhs");
+
     parent_t::update_rhs(rhs, dt, at);
 
-    // cell-wise
-    {
-      auto 
-	dot_rc = rhs.at(ix::rc)(this->ijk),
-	dot_rr = rhs.at(ix::rr)(this->ijk);
-      const auto 
-	rc   = this->state(ix::rc)(this->ijk),
-	rr   = this->state(ix::rr)(this->ijk);
-      libcloudphxx::blk_1m::rhs_cellwise<real_t>(opts, dot_rc, dot_rr, rc, rr);
-    }
+    (this->*rhs_fun)(rhs);
+  }
 
-    // column-wise
-    for (int i = this->i.first(); i <= this->i.last(); ++i)
-    {
-      auto 
-	dot_rr = rhs.at(ix::rr)(i, this->j);
-      const auto 
-        rhod   = (*this->mem->G)(i, this->j),
-	rr     = this->state(ix::rr)(i, this->j);
-      libcloudphxx::blk_1m::rhs_columnwise<real_t>(opts, dot_rr, rhod, rr, this->dz);
-    }
+  // cell-wise and column-wise terms in one sweep over this thread's columns,
+  // instantiated for each combination of the process toggles
+  template <int procs>
+  void rhs_procs(libmpdataxx::arrvec_t<typename parent_t::arr_t> &rhs)
+  {
+    rhs_fused_blk_1m<procs>(
+      opts,
+      rhs.at(ix::rc), rhs.at(ix::rr),
+      *this->mem->G, this->state(ix::rc), this->state(ix::rr),
+      this->i, this->j,
+      this->dz
+    );
+  }
+
+  // the instantiation for the current toggles (picked in set_rain() rather than checked in every cell)
+  using rhs_fun_t = void (kin_cloud_2d_blk_1m::*)(libmpdataxx::arrvec_t<typename parent_t::arr_t> &);
+  rhs_fun_t rhs_fun;
+
+  template <int procs>
+  rhs_fun_t rhs_select(const int &) 
+  { 
+    return &kin_cloud_2d_blk_1m::template rhs_procs<procs>; // the last one if none matched
+  }
+
+  template <int procs, int next, int... more>
+  rhs_fun_t rhs_select(const int &mask) 
+  { 
+    return mask == procs ? &kin_cloud_2d_blk_1m::template rhs_procs<procs> : rhs_select<next, more...>(mask);
   }
 
   // 
   void hook_post_step()
   {
+    scoped_timer tmr(this->timers(), "hook_post_step");
+
     condevap(); // treat saturation adjustment as post-advection, pre-rhs adjustment
     parent_t::hook_post_step(); // includes the above forcings
   }
@@ -103,6 +169,7 @@ class kin_cloud_2d_blk_1m : public kin_cloud_2d_common<ct_params_t>
   struct rt_params_t : parent_t::rt_params_t 
   { 
     libcloudphxx::blk_1m::opts_t<real_t> cloudph_opts;
+    adj_t adj = adj_t::scalar;
   };
 
   // ctor
@@ -111,6 +178,9 @@ class kin_cloud_2d_blk_1m : public kin_cloud_2d_common<ct_params_t>
     const rt_params_t &p
   ) : 
     parent_t(args, p),
+    adj(p.adj),
     opts(p.cloudph_opts)
-  {}  
+  {
+    select_rhs();
+  }  
 };
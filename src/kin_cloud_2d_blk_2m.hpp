@@ -1,8 +1,8 @@
 #include "kin_cloud_2d_common.hpp"
 
 #include <libcloudph++/blk_2m/options.hpp>
-#include <libcloudph++/blk_2m/rhs_cellwise.hpp>
-#include <libcloudph++/blk_2m/rhs_columnwise.hpp>
+
+#include "rhs_fused.hpp"
 
 template <class ct_params_t>
 class kin_cloud_2d_blk_2m : public kin_cloud_2d_common<ct_params_t>
@@ -25,55 +25,43 @@ class kin_cloud_2d_blk_2m : public kin_cloud_2d_common<ct_params_t>
     const typename parent_t::real_t &dt,
     const int &at 
   ) {
+    scoped_timer tmr(this->timers(), "update_rhs");
+
     parent_t::update_rhs(rhs, dt, at);
 
-    this->mem->barrier(); // TODO: if neccesarry, then move to adv_rhs/....hpp
-
-    // cell-wise
-    {
-      auto
-	dot_th = rhs.at(ix::th)(this->ijk),
-	dot_rv = rhs.at(ix::rv)(this->ijk),
-	dot_rc = rhs.at(ix::rc)(this->ijk),
-	dot_rr = rhs.at(ix::rr)(this->ijk),
-	dot_nc = rhs.at(ix::nc)(this->ijk),
-	dot_nr = rhs.at(ix::nr)(this->ijk);
-      const auto
-        rhod   = (*this->mem->G)(this->ijk),
-        th     = this->state(ix::th)(this->ijk),
-        rv     = this->state(ix::rv)(this->ijk),
-        rc     = this->state(ix::rc)(this->ijk),
-        rr     = this->state(ix::rr)(this->ijk),
-        nc     = this->state(ix::nc)(this->ijk),
-        nr     = this->state(ix::nr)(this->ijk);
-
-      libcloudphxx::blk_2m::rhs_cellwise<real_t>(
-        opts, dot_th, dot_rv, dot_rc, dot_nc, dot_rr, dot_nr,
-	rhod,     th,     rv,     rc,     nc,     rr,     nr,
-        this->dt
-      );
-    }
-
-    // column-wise
-    for (int i = this->i.first(); i <= this->i.last(); ++i)
-    {
-      auto
-	dot_rr = rhs.at(ix::rr)(i, this->j),
-	dot_nr = rhs.at(ix::nr)(i, this->j);
-      const auto
-        rhod   = (*this->mem->G)(i, this->j),
-	rr     = this->state(ix::rr)(i, this->j),
-	nr     = this->state(ix::nr)(i, this->j);
-
-      libcloudphxx::blk_2m::rhs_columnwise<real_t>(
-        opts, dot_rr, dot_nr, 
-        rhod,     rr,     nr,  
-	this->dt,
-	this->dz
-      );
-    }
-
-    this->mem->barrier(); // TODO: if needed, move to adv+rhs
+    (this->*rhs_fun)(rhs);
+  }
+
+  // cell-wise and column-wise terms in one sweep over this thread's columns
+  // (no barriers needed: only this thread's part of the rhs and state arrays is touched),
+  // instantiated for the commonly used combinations of the process toggles
+  template <int procs>
+  void rhs_procs(libmpdataxx::arrvec_t<typename parent_t::arr_t> &rhs)
+  {
+    rhs_fused_blk_2m<procs>(
+      opts,
+      rhs.at(ix::th), rhs.at(ix::rv), rhs.at(ix::rc), rhs.at(ix::nc), rhs.at(ix::rr), rhs.at(ix::nr),
+      *this->mem->G, 
+      this->state(ix::th), this->state(ix::rv), this->state(ix::rc), this->state(ix::nc), this->state(ix::rr), this->state(ix::nr),
+      this->i, this->j,
+      this->dt, this->dz
+    );
+  }
+
+  // the instantiation for the current toggles (picked in set_rain() rather than checked in every cell)
+  using rhs_fun_t = void (kin_cloud_2d_blk_2m::*)(libmpdataxx::arrvec_t<typename parent_t::arr_t> &);
+  rhs_fun_t rhs_fun;
+
+  template <int procs>
+  rhs_fun_t rhs_select(const int &) 
+  { 
+    return &kin_cloud_2d_blk_2m::template rhs_procs<procs>; // the last one if none matched
+  }
+
+  template <int procs, int next, int... more>
+  rhs_fun_t rhs_select(const int &mask) 
+  { 
+    return mask == procs ? &kin_cloud_2d_blk_2m::template rhs_procs<procs> : rhs_select<next, more...>(mask);
   }
 
   libcloudphxx::blk_2m::opts_t<real_t> opts;
@@ -97,8 +85,42 @@ class kin_cloud_2d_blk_2m : public kin_cloud_2d_common<ct_params_t>
   { 
     opts.acnv = val; 
     opts.RH_max = val ? 44 : 1.01; // 1% limit during spinup
+    select_rhs();
   };
 
+  void select_rhs()
+  {
+    using namespace procs_blk_2m;
+    rhs_fun = rhs_select<
+      0,                                      // advection only
+      acti | cond,                            // no rain
+      acti | cond |        accr,              // spinup ...
+      acti | cond |        accr | sedi,       // ... with sedimentation
+      acti | cond | acnv | accr,              // no sedimentation
+      acti | cond | acnv | accr | sedi,       // all processes
+      procs_rt                                // any other combination
+    >(mask(opts));
+  }
+
+  // for the in-situ reductions
+  const typename parent_t::arr_t *cloud_water() { return &this->state(ix::rc); }
+  const typename parent_t::arr_t *rain_water() { return &this->state(ix::rr); }
+
+  bool rain_sedi(typename parent_t::arr_t &dot_rr, typename parent_t::arr_t &tmp) 
+  {
+    dot_rr = 0;
+    tmp = 0;
+    if (opts.sedi) rhs_fused_blk_2m<procs_blk_2m::sedi>( // note: only dot_rr and dot_nr touched
+      opts,
+      tmp, tmp, tmp, tmp, dot_rr, tmp,
+      *this->mem->G, 
+      this->state(ix::th), this->state(ix::rv), this->state(ix::rc), this->state(ix::nc), this->state(ix::rr), this->state(ix::nr),
+      this->i, this->j,
+      this->dt, this->dz
+    );
+    return true;
+  }
+
   public:
 
   struct rt_params_t : parent_t::rt_params_t 
@@ -115,6 +137,7 @@ class kin_cloud_2d_blk_2m : public kin_cloud_2d_common<ct_params_t>
     opts(p.cloudph_opts)
   { 
     assert(p.dt != 0);
+    select_rhs();
   }  
 };
 
@@ -3,6 +3,21 @@
 #include <libmpdata++/solvers/mpdata_rhs.hpp>
 #include <libmpdata++/output/hdf5.hpp>
 
+#include "timing.hpp"
+#include "h5_writer.hpp"
+#include "checkpoint.hpp"
+#include "reductions.hpp"
+#include "level_sums.hpp"
+#include "adj_simd.hpp"
+#include "threads.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <iomanip>
+
 using namespace libmpdataxx; // TODO: get rid of it?
 
 template <class ct_params_t>
@@ -22,22 +37,502 @@ class kin_cloud_2d_common : public
   virtual bool get_rain() = 0;
   virtual void set_rain(bool) = 0;
 
+  // per-phase wall-clock timers (all nullptr-guarded no-ops if timing is off)
+  std::shared_ptr<timing_t> timing; // shared among threads
+  timers_t tmrs;                    // this thread's ones
+
+  timers_t *timers() 
+  { 
+    return timing ? &tmrs : nullptr; 
+  }
+
+  // the thread budget and placement (see threads.hpp)
+  thread_layout_t threads;
+
+  // barrier with the waiting time accounted for (to expose load imbalance)
+  void timed_barrier()
+  {
+    scoped_timer tmr(timers(), "barrier");
+    this->mem->barrier();
+  }
+
+  // own output used instead of libmpdata++'s one with out_async, with storage filters or with record_aux_nd(): 
+  // rank 0 stages copies of the fields, the HDF5 calls are done by a writer thread 
+  // (out_async) or right away by sync_writer (on rank 0 only, nullptr otherwise)
+  bool out_async;
+  int out_queue;
+  h5_filters_t out_filters;
+  bool out_own; // own output even if nothing else calls for it (needed by record_aux_nd())
+  bool out_series; // all output steps in outdir/series.h5, see h5_field_t::record
+  std::map<std::string, int> out_sched; // output intervals by variable-name prefix, see out_freq()
+  std::unique_ptr<h5_async_writer_t> writer;
+  std::unique_ptr<h5_writer_t> sync_writer;
+  std::string staged_file; // the file the last staged field goes to
+
+  bool own_output()
+  {
+    return writer || sync_writer;
+  }
+
+  // the output interval of a variable (0 -> never): the one of the longest matching prefix in out_sched, outfreq if none
+  int out_freq(const std::string &name) const
+  {
+    auto ret = out_sched.end();
+    for (auto it = out_sched.begin(); it != out_sched.end(); ++it)
+      if (name.compare(0, it->first.size(), it->first) == 0 && (ret == out_sched.end() || it->first.size() > ret->first.size())) 
+        ret = it;
+    return ret == out_sched.end() ? this->outfreq : ret->second;
+  }
+
+  // whether a variable is to be output at this timestep
+  bool out_due(const std::string &name) const
+  {
+    const int freq = out_freq(name);
+    return freq > 0 && this->timestep % freq == 0;
+  }
+
+  // the file libmpdata++'s output writes the current timestep to
+  std::string timestep_file()
+  {
+    std::ostringstream file;
+    file << this->outdir << "/timestep" << std::setw(10) << std::setfill('0') << this->timestep << ".h5";
+    return file.str();
+  }
+
+  std::unique_ptr<h5_field_t> stage(const std::string &name, const std::string &unit = "")
+  {
+    auto fld = writer ? writer->acquire() : std::unique_ptr<h5_field_t>(new h5_field_t());
+    if (!out_series)
+    {
+      fld->file = timestep_file();
+      fld->create = fld->file != staged_file;
+      fld->record = -1;
+    }
+    else
+    {
+      fld->file = this->outdir + "/series.h5";
+      fld->create = staged_file.empty() && restart.empty(); // appending if restarting
+    }
+    fld->name = name;
+    fld->unit = unit;
+    fld->chunk.clear(); // the record might be a recycled one
+    fld->attrs.clear();
+    if (out_series)
+    {
+      // one record per output of the variable (i.e. no gaps if output less often than every outfreq)
+      const int freq = name == "timestep" ? this->outfreq : out_freq(name);
+      fld->record = this->timestep / freq;
+      fld->attrs["timestep_freq"] = {double(freq)};
+    }
+    staged_file = fld->file;
+    return fld;
+  }
+
+  void put(std::unique_ptr<h5_field_t> fld)
+  {
+    if (writer) writer->push(std::move(fld));
+    else sync_writer->write(*fld);
+  }
+
+  int nt_end; // the last timestep of the run (see hook_ante_loop())
+
+  // all output on disk and the files closed, with any error thrown here (instead of being lost 
+  // in the destructors); done by rank 0 once the output of the last timestep is staged (at the 
+  // end of hook_post_step(), and again by the derived classes doing output after the parent's one)
+  void finish_output()
+  {
+    assert(this->rank == 0);
+    if (writer) writer->flush();
+    if (sync_writer) sync_writer->close();
+    if (red_writer) red_writer->close();
+  }
+
+  // in-situ reductions (nullptr -> off), the results written by rank 0 to outdir/diag.h5
+  std::shared_ptr<reductions_t> reductions; // shared among threads
+  std::unique_ptr<h5_writer_t> red_writer;
+  bool red_written = false;
+  adj_simd_t<typename ct_params_t::real_t, double> thermo; // for the supersaturation
+  typename parent_t::arr_t red_tmp[2]; // this thread's columns, for the sedimentation tendencies
+
+  // the condensate mixing ratios for the reductions (nullptr if not a part of the model state)
+  virtual const typename parent_t::arr_t *cloud_water() { return nullptr; }
+  virtual const typename parent_t::arr_t *rain_water() { return nullptr; }
+
+  // the rr tendency due to sedimentation alone in this thread's columns (for the surface 
+  // precipitation flux, tmp being a scratch array of the same shape); false if not available
+  virtual bool rain_sedi(typename parent_t::arr_t &dot_rr, typename parent_t::arr_t &tmp) { return false; }
+
+  // false -> reduce() called by the derived class instead of at the end of hook_ante_loop() and 
+  // hook_post_step() (e.g. after its microphysics step has adjusted th and rv), by all the ranks
+  bool reduce_in_hooks = true;
+
+  void reduce()
+  {
+    if (!reductions || this->timestep % reductions->freq != 0) return;
+    scoped_timer tmr(timers(), "reductions");
+
+    using ix = typename ct_params_t::ix;
+    const int nx = this->mem->grid_size[0], nz = this->mem->grid_size[1], j0 = this->j.first();
+    const auto &rhod = *this->mem->G, &th = this->state(ix::th), &rv = this->state(ix::rv);
+    const auto *rc = cloud_water(), *rr = rain_water();
+    const double r_cloudy = 1e-5; // [kg kg-1] cloud water mixing ratio threshold of cloud_cover
+
+    // the quantities requested (looked up once, not per cell)
+    const bool
+      on_lwp   = rc != nullptr && reductions->on("lwp"),
+      on_rwp   = rr != nullptr && reductions->on("rwp"),
+      on_cover = rc != nullptr && reductions->on("cloud_cover"),
+      on_smax  = reductions->on("smax");
+
+    // scalars followed by the profiles
+    enum { lwp, rwp, cover, precip, smax, n_scalar };
+    const int n_prof = !reductions->on("prof") ? 0 : rc == nullptr ? 2 : 4; 
+    std::vector<double> &part = reductions->slot(this->rank, n_scalar + n_prof * nz);
+    part[smax] = -std::numeric_limits<double>::infinity();
+
+    for (int i = this->i.first(); i <= this->i.last(); ++i)
+    {
+      bool cloudy = false;
+      for (int j = this->j.first(); j <= this->j.last(); ++j)
+      {
+        if (on_lwp) part[lwp] += rhod(i, j) * (*rc)(i, j);
+        if (on_rwp) part[rwp] += rhod(i, j) * (*rr)(i, j);
+        if (on_cover) cloudy = cloudy || (*rc)(i, j) > r_cloudy;
+        if (on_smax) part[smax] = std::max(part[smax], thermo.ss(rhod(i, j), th(i, j), rv(i, j)));
+        if (n_prof > 0)
+        {
+          double *prof = &part[n_scalar + j - j0];
+          prof[0 * nz] += th(i, j);
+          prof[1 * nz] += rv(i, j);
+          if (n_prof > 2)
+          {
+            prof[2 * nz] += (*rc)(i, j);
+            prof[3 * nz] += (*rr)(i, j);
+          }
+        }
+      }
+      part[cover] += cloudy;
+    }
+
+    // the outflow through the open bottom boundary being the only one of sedimentation, 
+    // the column integral of its tendency gives the surface flux
+    if (reductions->on("precip") && rain_sedi(red_tmp[0], red_tmp[1]))
+      for (int i = this->i.first(); i <= this->i.last(); ++i)
+        for (int j = this->j.first(); j <= this->j.last(); ++j)
+          part[precip] -= rhod(i, j) * red_tmp[0](i, j) * this->dz;
+
+    timed_barrier();
+
+    // note: the slots are not touched again before the next step's barriers, i.e. not before rank 0 is done
+    if (this->rank != 0) return;
+
+    const std::vector<double> tot = reductions->combine({smax});
+    auto record = [&](const std::string &name, const std::string &unit, const double *data, const int n)
+    {
+      h5_field_t fld;
+      fld.file = this->outdir + "/diag.h5";
+      fld.create = !red_written && restart.empty(); // appending if restarting
+      fld.record = this->timestep / reductions->freq;
+      fld.name = name;
+      fld.unit = unit;
+      if (n > 1) fld.shape = {hsize_t(n)};
+      fld.data.assign(data, data + n);
+      red_writer->write(fld);
+      red_written = true;
+    };
+
+    const double t = this->timestep, 
+      means[] = {tot[lwp] * this->dz / nx, tot[rwp] * this->dz / nx, tot[cover] / nx, tot[precip] / nx};
+    // the units given as in the outvars of the opts_*.hpp files
+    record("timestep", "[1]", &t, 1);
+    if (on_lwp)                        record("lwp",         "[kg m-2]",      &means[lwp],    1);
+    if (on_rwp)                        record("rwp",         "[kg m-2]",      &means[rwp],    1);
+    if (on_cover)                      record("cloud_cover", "[1]",           &means[cover],  1);
+    if (reductions->on("precip"))      record("precip",      "[kg m-2 s-1]",  &means[precip], 1);
+    if (on_smax)                       record("smax",        "[1]",           &tot[smax],     1);
+
+    const char *prof_names[] = {"prof_th", "prof_rv", "prof_rc", "prof_rr"}, *prof_units[] = {"[K]", "[kg kg-1]", "[kg kg-1]", "[kg kg-1]"};
+    for (int p = 0; p < n_prof; ++p)
+    {
+      std::vector<double> prof(tot.begin() + n_scalar + p * nz, tot.begin() + n_scalar + (p + 1) * nz);
+      for (auto &v : prof) v /= nx;
+      record(prof_names[p], prof_units[p], prof.data(), nz);
+    }
+  }
+
+  // relaxation of the horizontal th and rv anomalies (i.e. of the deviations from the level means)
+  std::vector<double> relax_inv_tau; // inverse timescale per level (empty -> no relaxation)
+  std::shared_ptr<level_sums_t> level_sums; // shared among threads
+  int relax_parity = 0; // of the level_sums buffer used in the next call
+  std::vector<double> relax_mean; 
+
+  void relax(arrvec_t<typename parent_t::arr_t> &rhs)
+  {
+    scoped_timer tmr(timers(), "relax");
+
+    using ix = typename ct_params_t::ix;
+    const int vars[] = {ix::th, ix::rv}, nx = this->mem->grid_size[0], nz = relax_inv_tau.size(), j0 = this->j.first();
+
+    // the partial sums of all the levels and variables with this thread's columns ...
+    std::vector<double> &part = level_sums->slot(this->rank, relax_parity);
+    std::fill(part.begin(), part.end(), 0);
+    for (int v = 0; v < 2; ++v)
+    {
+      const auto &psi = this->state(vars[v]);
+      for (int i = this->i.first(); i <= this->i.last(); ++i)
+        for (int j = this->j.first(); j <= this->j.last(); ++j)
+          part[v * nz + j - j0] += psi(i, j);
+    }
+
+    // ... combined by each thread after a single barrier
+    timed_barrier();
+    level_sums->combine(relax_parity, relax_mean);
+    relax_parity ^= 1;
+
+    for (int v = 0; v < 2; ++v)
+    {
+      const auto &psi = this->state(vars[v]);
+      auto &dot_psi = rhs.at(vars[v]);
+      for (int i = this->i.first(); i <= this->i.last(); ++i)
+        for (int j = this->j.first(); j <= this->j.last(); ++j)
+          dot_psi(i, j) -= (psi(i, j) - relax_mean[v * nz + j - j0] / nx) * relax_inv_tau[j - j0];
+    }
+  }
+
+  // checkpointing: the full model state is written by rank 0 every checkpoint_freq steps
+  int checkpoint_freq;
+  std::string restart; // checkpoint file to resume from (empty -> none)
+  int restart_timestep;
+  bool restart_rain;
+
+  // state at the end of spinup stored for reuse by runs with the same spinup_key (see run() in icicle.cpp)
+  std::string spinup_save; // empty -> not saving
+  std::string spinup_key;
+
+  void save_checkpoint(const std::string &file)
+  {
+    this->mem->barrier();
+    if (this->rank == 0)
+    {
+      scoped_timer tmr(timers(), "checkpoint");
+
+      // output up to the checkpoint on disk (and no concurrent HDF5 calls)
+      if (writer) writer->flush();
+      if (sync_writer) sync_writer->close();
+      if (red_writer) red_writer->close();
+
+      // written under a temporary name not to leave a partial file if interrupted
+      const std::string tmp = checkpoint_t::tmp_file(file);
+      {
+        h5_lock_t lock(h5_mutex());
+        checkpoint_t chkp(tmp, true);
+        for (int e = 0; e < ct_params_t::n_eqns; ++e) 
+          chkp.put("psi_" + std::to_string(e), this->mem->advectee(e));
+        chkp.put("G", *this->mem->G);
+        for (int d = 0; d < ct_params_t::n_dims; ++d) 
+          chkp.put("GC_" + std::to_string(d), this->mem->GC[d]);
+        chkp.put_attr("timestep", this->timestep);
+        chkp.put_attr("rain", get_rain());
+        chkp.close();
+      }
+      if (std::rename(tmp.c_str(), file.c_str()) != 0) 
+        throw std::runtime_error("failed to rename " + tmp + " to " + file);
+    }
+    this->mem->barrier();
+  }
+
+  void load_checkpoint()
+  {
+    this->mem->barrier();
+    if (this->rank == 0)
+    {
+      h5_lock_t lock(h5_mutex());
+      checkpoint_t chkp(restart, false);
+      for (int e = 0; e < ct_params_t::n_eqns; ++e) 
+        chkp.get("psi_" + std::to_string(e), this->mem->advectee(e));
+      chkp.get("G", *this->mem->G);
+      for (int d = 0; d < ct_params_t::n_dims; ++d) 
+        chkp.get("GC_" + std::to_string(d), this->mem->GC[d]);
+    }
+    this->mem->barrier();
+
+    // per-thread state (read from the file beforehand, see run() in icicle.cpp)
+    this->timestep = restart_timestep;
+    set_rain(restart_rain);
+  }
+
   void hook_ante_loop(int nt) 
   {
+    nt_end = nt; // the loop bound (see run() in icicle.cpp)
+
     if (get_rain() == false) spinup = 0; // spinup does not make sense without autoconversion  (TODO: issue a warning?)
     if (spinup > 0) set_rain(false);
 
-    parent_t::hook_ante_loop(nt); 
+    // one core per advection thread (if pinning)
+    if (this->rank < int(threads.cpus_adv.size())) pin_thread({threads.cpus_adv[this->rank]});
+
+    // overwriting the initial condition (and the derived classes' adjustments to it)
+    if (!restart.empty()) load_checkpoint();
+
+    // before the parent's hook as it does the output of the initial condition
+    if (this->rank == 0)
+    {
+      if (out_async) writer.reset(new h5_async_writer_t(out_queue, out_filters));
+      else if (out_own || !out_filters.empty() || out_series || !out_sched.empty()) sync_writer.reset(new h5_writer_t(out_filters));
+      if (reductions) red_writer.reset(new h5_writer_t(h5_filters_t()));
+    }
+    if (reductions) for (auto &tmp : red_tmp) tmp.resize(this->i, this->j);
+
+    // before the parent's hook as it evaluates the rhs
+    if (!relax_inv_tau.empty())
+    {
+      level_sums->init(this->rank, 2 * relax_inv_tau.size());
+      this->mem->barrier();
+    }
+
+    // libmpdata++'s output (coord.h5 and the initial condition) written by rank 0 within; 
+    // note: the async writer (if any) has nothing pending yet, i.e. push() does not block 
+    // (which, with the lock held, would be waiting for the writer thread waiting for the lock)
+    {
+      std::unique_lock<std::recursive_mutex> lock(h5_mutex(), std::defer_lock);
+      if (this->rank == 0) lock.lock();
+      parent_t::hook_ante_loop(nt); 
+    }
+
+    // the layout in a file of its own (coord.h5 being libmpdata++'s one)
+    if (this->rank == 0)
+    {
+      h5_lock_t lock(h5_mutex());
+      record_layout(this->outdir + "/threads.h5", threads);
+    }
+
+    if (reduce_in_hooks) reduce(); // of the initial condition
   }
 
   void hook_ante_step()
   {
+    // wall time of a step is measured between subsequent hook_ante_step() calls
+    if (timing) 
+    {
+      if (tmrs.running("step")) tmrs.stop("step");
+      tmrs.start("step");
+    }
+    scoped_timer tmr(timers(), "hook_ante_step");
+
     // turn autoconversion on only after spinup (if spinup was specified)
     if (spinup != 0 && spinup == this->timestep) set_rain(true);
 
     parent_t::hook_ante_step(); 
   }
 
+  // note: the derived classes time their own hook_post_step() and update_rhs() under the same names
+  void hook_post_step()
+  {
+    scoped_timer tmr(timers(), "hook_post_step");
+    parent_t::hook_post_step(); 
+
+    if (reduce_in_hooks) reduce();
+
+    if (checkpoint_freq > 0 && this->timestep % checkpoint_freq == 0) 
+      save_checkpoint(checkpoint_t::file(this->outdir, this->timestep));
+
+    if (!spinup_save.empty() && this->timestep == spinup) 
+    {
+      // the key first, so that a complete checkpoint always comes with it (both renamed 
+      // into place, as other runs with the same key may be reading or writing them)
+      if (this->rank == 0) 
+      {
+        const std::string tmp = checkpoint_t::tmp_file(spinup_save + ".key");
+        std::ofstream(tmp) << spinup_key << std::endl;
+        if (std::rename(tmp.c_str(), (spinup_save + ".key").c_str()) != 0) 
+          throw std::runtime_error("failed to rename " + tmp + " to " + spinup_save + ".key");
+      }
+      save_checkpoint(spinup_save);
+    }
+
+    if (this->timestep == nt_end && this->rank == 0) finish_output();
+  }
+
+  void record_all()
+  {
+    scoped_timer tmr(timers(), "output");
+
+    if (!own_output()) 
+    {
+      h5_lock_t lock(h5_mutex());
+      parent_t::record_all();
+      return;
+    }
+
+    // the time coordinate of the records
+    if (out_series)
+    {
+      auto fld = stage("timestep");
+      fld->shape.clear();
+      fld->data.assign(1, this->timestep);
+      put(std::move(fld));
+    }
+
+    for (const auto &v : this->outvars)
+    {
+      if (!out_due(v.second.name)) continue;
+      const auto psi = this->mem->advectee(v.first);
+      auto fld = stage(v.second.name, v.second.unit);
+      fld->shape = {hsize_t(psi.extent(0)), hsize_t(psi.extent(1))};
+      fld->data.resize(psi.numElements());
+      auto it = fld->data.begin();
+      for (int i = psi.lbound(0); i <= psi.ubound(0); ++i)
+        for (int j = psi.lbound(1); j <= psi.ubound(1); ++j)
+          *it++ = psi(i, j);
+      put(std::move(fld));
+    }
+  }
+
+  void record_aux(const std::string &name, typename parent_t::real_t *data)
+  {
+    scoped_timer tmr(timers(), "output");
+
+    if (!own_output()) 
+    {
+      h5_lock_t lock(h5_mutex());
+      parent_t::record_aux(name, data);
+      return;
+    }
+    if (!out_due(name)) return;
+
+    const int nx = this->mem->grid_size[0], nz = this->mem->grid_size[1];
+    auto fld = stage(name);
+    fld->shape = {hsize_t(nx), hsize_t(nz)};
+    fld->data.assign(data, data + nx * nz);
+    put(std::move(fld));
+  }
+
+  // an aux field of any shape (e.g. with leading dimensions for spectra), 
+  // optionally chunked and with numeric attributes (e.g. coordinates)
+  void record_aux_nd(
+    const std::string &name, 
+    const std::vector<hsize_t> &shape, 
+    const std::vector<hsize_t> &chunk, 
+    const std::map<std::string, std::vector<double>> &attrs,
+    const typename parent_t::real_t *data
+  )
+  {
+    scoped_timer tmr(timers(), "output");
+    if (!out_due(name)) return;
+
+    // not through a second handle to libmpdata++'s timestep file (which stays open until the next record_all())
+    if (!own_output()) throw std::logic_error("record_aux_nd() requires own output (rt_params.out_own)");
+
+    auto fld = stage(name);
+    fld->shape = shape;
+    fld->chunk = chunk;
+    fld->attrs.insert(attrs.begin(), attrs.end());
+    hsize_t n = 1;
+    for (auto &s : shape) n *= s;
+    fld->data.assign(data, data + n);
+
+    put(std::move(fld));
+  }
 
   void update_rhs(
     arrvec_t<typename parent_t::arr_t> &rhs,
@@ -45,27 +540,12 @@ class kin_cloud_2d_common : public
     const int &at 
   )   
   {   
-    parent_t::update_rhs(rhs, dt, at);
+    scoped_timer tmr(timers(), "update_rhs");
 
-    // relaxation terms
-    {
-      // computed level-wise
-      //for (int j = 0; j < this->span[0]; ++j)
-      {  
-        // th
-        {
-          // TODO ...
-          //const auto &psi = this->state(ix::th);
-          //const auto psi_mean = this->mem->sum(psi, this->i, j) / this->span[0];
-          //rhs.at(ix::th)(this->i, j) = - (psi(this->i, j) - psi_mean) / tau(j...);
-        }
-        // rv
-        {
-          // TODO: same as above...
-        }
-      }
-    }
+    parent_t::update_rhs(rhs, dt, at);
 
+    // relaxation terms (known at compile time not to be there if th and rv have no rhs)
+    if (ct_params_t::relax && !relax_inv_tau.empty()) relax(rhs);
   }
 
   public:
@@ -74,6 +554,22 @@ class kin_cloud_2d_common : public
   { 
     typename ct_params_t::real_t dx = 0, dz = 0;
     int spinup = 0; // number of timesteps during which autoconversion is to be turned off
+    std::shared_ptr<timing_t> timing; // nullptr -> timing off
+    thread_layout_t threads;
+    bool out_async = false;
+    int out_queue = 2; // max. number of output steps pending with out_async
+    h5_filters_t out_filters; // chunking, compression and quantisation (none -> libmpdata++'s output if not out_async)
+    bool out_own = false; // see record_aux_nd()
+    bool out_series = false;
+    std::map<std::string, int> out_sched; // see out_freq()
+    std::shared_ptr<reductions_t> reductions; // nullptr -> no in-situ reductions
+    std::vector<std::pair<double, double>> relax_tau; // (height [m], timescale [s]) points in ascending height (empty -> no relaxation)
+    std::shared_ptr<level_sums_t> level_sums; // required with relax_tau
+    int checkpoint_freq = 0; // 0 -> no checkpoints
+    std::string restart; 
+    int restart_timestep = 0;
+    bool restart_rain = false;
+    std::string spinup_save, spinup_key;
   };
 
   // ctor
@@ -84,9 +580,52 @@ class kin_cloud_2d_common : public
     parent_t(args, p),
     dx(p.dx),
     dz(p.dz),
-    spinup(p.spinup)
+    spinup(p.spinup),
+    timing(p.timing),
+    threads(p.threads),
+    out_async(p.out_async),
+    out_queue(p.out_queue),
+    out_filters(p.out_filters),
+    out_own(p.out_own),
+    out_series(p.out_series),
+    out_sched(p.out_sched),
+    reductions(p.reductions),
+    level_sums(p.level_sums),
+    checkpoint_freq(p.checkpoint_freq),
+    restart(p.restart),
+    restart_timestep(p.restart_timestep),
+    restart_rain(p.restart_rain),
+    spinup_save(p.spinup_save),
+    spinup_key(p.spinup_key)
   {
     assert(dx != 0);
     assert(dz != 0);
+
+    // the timescale profile interpolated linearly to the levels (and constant outside of the given heights)
+    if (!p.relax_tau.empty())
+    {
+      if (!ct_params_t::relax) throw std::logic_error("relaxation terms not compiled in (see ct_params.hpp)");
+      assert(level_sums);
+      const auto &tau = p.relax_tau;
+      for (int j = 0; j < p.grid_size[1]; ++j)
+      {
+        const double z = j * dz;
+        auto hi = std::upper_bound(tau.begin(), tau.end(), z, [](const double &z, const std::pair<double, double> &pt) { return z < pt.first; });
+        const double t = 
+          hi == tau.begin() ? hi->second :
+          hi == tau.end()   ? std::prev(hi)->second :
+          std::prev(hi)->second + (hi->second - std::prev(hi)->second) * (z - std::prev(hi)->first) / (hi->first - std::prev(hi)->first);
+        relax_inv_tau.push_back(1 / t);
+      }
+    }
   }  
+
+  // dtor (pending output gets written when the writer goes away, 
+  // including the case of a loop interrupted by a signal, see panic.hpp)
+  ~kin_cloud_2d_common()
+  {
+    if (!timing) return;
+    if (tmrs.running("step")) tmrs.stop("step"); // the last timestep
+    timing->store(this->rank, tmrs);
+  }
 };
@@ -2,11 +2,16 @@
 
 #include "kin_cloud_2d_common.hpp"
 #include "outmom.hpp"
+#include "worker.hpp"
 
 #include <libcloudph++/lgrngn/factory.hpp>
 
-#if defined(STD_FUTURE_WORKS)
-#  include <future>
+#include <iterator>
+#include <map>
+#include <numeric>
+
+#if defined(_OPENMP)
+#  include <omp.h>
 #endif
 
 // @brief a minimalistic kinematic cloud model with lagrangian microphysics
@@ -25,48 +30,139 @@ class kin_cloud_2d_lgrngn : public kin_cloud_2d_common<ct_params_t>
 
   // member fields
   std::unique_ptr<libcloudphxx::lgrngn::particles_proto_t<real_t>> prtcls;
+  std::unique_ptr<worker_t> worker; // runs step_async() concurrently with advection (destroyed before prtcls)
 
   // helper methods
   void diag()
   {
     assert(this->rank == 0);
+    scoped_timer tmr(this->timers(), "diag");
 
     // recording super-droplet concentration per grid cell 
-    prtcls->diag_sd_conc();
-    this->record_aux("sd_conc", prtcls->outbuf());
+    if (this->out_due("sd_conc"))
+    {
+      prtcls->diag_sd_conc();
+      this->record_aux("sd_conc", prtcls->outbuf());
+    }
    
-    // recording requested statistical moments
+    // recording requested statistical moments (the ones due at this timestep, see --out_sched)
+    diag_spec(
+      "rd", params.out_dry, spec_dry,
+      [&](const real_t &r1, const real_t &r2) { prtcls->diag_dry_rng(r1, r2); },
+      [&](const int &k) { prtcls->diag_dry_mom(k); }
+    );
+    diag_spec(
+      "rw", params.out_wet, spec_wet,
+      [&](const real_t &r1, const real_t &r2) { prtcls->diag_wet_rng(r1, r2); },
+      [&](const int &k) { prtcls->diag_wet_mom(k); }
+    );
+  } 
+
+  // (range x moment x cell) buffers in the order of the outmom_t spec (--out_spec=compact only)
+  std::vector<real_t> spec_dry, spec_wet;
+
+  int n_cell()
+  {
+    return params.cloudph_opts_init.nx * params.cloudph_opts_init.nz;
+  }
+
+  // the name of the dataset moment k of range number rng goes to (the one its output schedule is looked up by)
+  std::string spec_name(
+    const std::string &pfx,
+    const outmom_t<real_t> &moms,
+    const int rng,
+    const int k
+  )
+  {
+    if (!params.out_spec_compact) return aux_name(pfx, rng, k);
+
+    // the first one of the consecutive ranges with the same moments (see record_spec_compact())
+    auto it = std::next(moms.begin(), rng);
+    int first = rng;
+    for (; first > 0 && std::prev(it)->second == it->second; --first) --it;
+    std::ostringstream name;
+    name << pfx << "_spec_rng" << std::setw(3) << std::setfill('0') << first;
+    return name.str();
+  }
+
+  // one pass of diag_rng() per range and one pass of diag_mom() per moment (particle-level access, 
+  // and hence a single sweep, is not offered by particles_proto_t - see TODO), skipping the ranges 
+  // and moments not due at this timestep; the results are recorded straight from outbuf() or, 
+  // with --out_spec=compact, gathered in buf first (leaving the parts not due as they are)
+  template <class diag_rng_t, class diag_mom_t>
+  void diag_spec(
+    const std::string &pfx,
+    const outmom_t<real_t> &moms,
+    std::vector<real_t> &buf,
+    const diag_rng_t &diag_rng,
+    const diag_mom_t &diag_mom
+  )
+  {
+    const bool compact = params.out_spec_compact;
+    if (compact) buf.resize(outmom_size(moms) * n_cell());
+
+    int rng_num = 0;
+    auto it = buf.begin();
+    for (auto &rng_moms : moms)
     {
-      // dry
-      int rng_num = 0;
-      for (auto &rng_moms : params.out_dry)
+      auto &rng(rng_moms.first);
+      bool rng_done = false;
+      for (auto &mom : rng_moms.second)
       {
-        auto &rng(rng_moms.first);
-        prtcls->diag_dry_rng(rng.first / si::metres, rng.second / si::metres);
-        for (auto &mom : rng_moms.second)
+        const std::string name = spec_name(pfx, moms, rng_num, mom);
+        if (this->out_due(name))
         {
-          prtcls->diag_dry_mom(mom);
-          this->record_aux(aux_name("rd", rng_num, mom), prtcls->outbuf());
+          if (!rng_done) diag_rng(rng.first / si::metres, rng.second / si::metres);
+          rng_done = true;
+          diag_mom(mom);
+          real_t *out = prtcls->outbuf(); // note: a device-to-host copy with CUDA
+          if (compact) std::copy(out, out + n_cell(), it);
+          else this->record_aux(name, out);
         }
-        rng_num++;
+        if (compact) it += n_cell();
       }
+      rng_num++;
     }
+
+    if (compact) record_spec_compact(pfx, moms, buf);
+  }
+
+  // consecutive ranges with the same moments are written as one (range, moment, x, z) dataset
+  // named after the first range (e.g. rw_spec_rng002), chunked per range and with the range
+  // edges, the moment numbers and the number of the first range as attributes
+  void record_spec_compact(
+    const std::string &pfx,
+    const outmom_t<real_t> &moms,
+    std::vector<real_t> &buf
+  )
+  {
+    const hsize_t nx = params.cloudph_opts_init.nx, nz = params.cloudph_opts_init.nz;
+
+    int rng_num = 0;
+    auto ptr = buf.data();
+    for (auto first = moms.begin(); first != moms.end();)
     {
-      // wet
-      int rng_num = 0;
-      for (auto &rng_moms : params.out_wet)
+      std::map<std::string, std::vector<double>> attrs;
+      attrs["rng_first"] = {double(rng_num)};
+      attrs["moments"].assign(first->second.begin(), first->second.end());
+
+      auto last = first;
+      for (; last != moms.end() && last->second == first->second; ++last)
       {
-        auto &rng(rng_moms.first);
-        prtcls->diag_wet_rng(rng.first / si::metres, rng.second / si::metres);
-        for (auto &mom : rng_moms.second)
-        {
-          prtcls->diag_wet_mom(mom);
-          this->record_aux(aux_name("rw", rng_num, mom), prtcls->outbuf());
-        }
-        rng_num++;
+        attrs["rng_left"].push_back(last->first.first / si::metres);
+        attrs["rng_right"].push_back(last->first.second / si::metres);
       }
+
+      const hsize_t n_rng = attrs["rng_left"].size(), n_mom = first->second.size();
+      std::ostringstream name;
+      name << pfx << "_spec_rng" << std::setw(3) << std::setfill('0') << rng_num;
+      this->record_aux_nd(name.str(), {n_rng, n_mom, nx, nz}, {1, n_mom, nx, nz}, attrs, ptr);
+
+      ptr += n_rng * n_mom * n_cell();
+      rng_num += n_rng;
+      first = last;
     }
-  } 
+  }
 
   libcloudphxx::lgrngn::arrinfo_t<real_t> make_arrinfo(
     typename parent_t::arr_t arr
@@ -108,8 +204,32 @@ class kin_cloud_2d_lgrngn : public kin_cloud_2d_common<ct_params_t>
       assert(params.backend != -1);
       assert(params.dt != 0); 
 
-      // async does not make sense without CUDA
-      if (params.backend != libcloudphxx::lgrngn::CUDA) params.async = false;
+      // with async, step_async() is run by a persistent worker thread concurrently with
+      // the next advection step; on CPU backends the cores are split between the two:
+      // the worker's OpenMP team has threads.micro threads, the advection uses OMP_NUM_THREADS
+      // with pinning, the team is confined to the cores of the microphysics (by the affinity of 
+      // the thread creating it: the worker, or rank 0 sharing its core with the team if not async)
+      const int n = this->threads.micro; // 0 if not --backend=OpenMP
+      const std::vector<int> &cpus = this->threads.cpus_micro;
+      if (params.async)
+        worker.reset(new worker_t([n, cpus]{
+          pin_thread(cpus);
+#if defined(_OPENMP)
+          if (n > 0) omp_set_num_threads(n);
+#endif
+        }));
+      else 
+      {
+        if (!cpus.empty()) 
+        {
+          std::vector<int> tmp(cpus);
+          tmp.insert(tmp.end(), this->threads.cpus_adv.begin(), this->threads.cpus_adv.begin() + 1);
+          pin_thread(tmp);
+        }
+#if defined(_OPENMP)
+        if (n > 0) omp_set_num_threads(n);
+#endif
+      }
 
       params.cloudph_opts_init.dt = params.dt; // advection timestep = microphysics timestep
       params.cloudph_opts_init.dx = params.dx;
@@ -137,80 +257,90 @@ class kin_cloud_2d_lgrngn : public kin_cloud_2d_common<ct_params_t>
 	); 
       }
 
+      // super-droplet count for the throughput figures
+      if (this->timing)
+      {
+        prtcls->diag_sd_conc();
+        const real_t *sd_conc = prtcls->outbuf();
+        this->timing->n_sd = std::accumulate(
+          sd_conc, sd_conc + n_cell(), 0.
+        );
+      }
+
       // writing diagnostic data for the initial condition
       diag();
     }
-    // TODO: barrier?
-  }
+    this->timed_barrier();
 
-#if defined(STD_FUTURE_WORKS)
-  std::future<real_t> ftr;
-#endif
+    // of the initial condition as adjusted by init() above
+    this->reduce();
+  }
 
   // 
   void hook_post_step()
   {
+    scoped_timer tmr(this->timers(), "hook_post_step");
+
     parent_t::hook_post_step(); // includes output
 
-    this->mem->barrier();
+    this->timed_barrier();
 
     if (this->rank == 0) 
     {
-      // assuring previous async step finished ...
-#if defined(STD_FUTURE_WORKS)
-      if (
-        params.async && 
-        this->timestep != 0 && // ... but not in first timestep ...
-        ((this->timestep - 1) % this->outfreq != 0) // ... and not after diag call
-      ) {
-        assert(ftr.valid());
-        ftr.get();
-      } else assert(!ftr.valid());
-#endif
+      // assuring previous async step finished (a no-op if nothing was submitted)
+      if (worker)
+      {
+        scoped_timer tmr(this->timers(), "step_async_wait");
+        worker->wait();
+      }
 
       // running synchronous stuff
-      prtcls->step_sync(
-        params.cloudph_opts,
-        make_arrinfo(this->mem->advectee(ix::th)),
-        make_arrinfo(this->mem->advectee(ix::rv))
-      ); 
+      {
+        scoped_timer tmr(this->timers(), "step_sync");
+        prtcls->step_sync(
+          params.cloudph_opts,
+          make_arrinfo(this->mem->advectee(ix::th)),
+          make_arrinfo(this->mem->advectee(ix::rv))
+        ); 
+      }
 
       // running asynchronous stuff
+      if (worker)
       {
-        using libcloudphxx::lgrngn::particles_t;
-        using libcloudphxx::lgrngn::CUDA;
-
-#if defined(STD_FUTURE_WORKS)
-        if (params.async)
-        {
-          assert(!ftr.valid());
-          ftr = std::async(
-            std::launch::async, 
-            &particles_t<real_t, CUDA>::step_async, 
-            dynamic_cast<particles_t<real_t, CUDA>*>(prtcls.get()),
-            params.cloudph_opts
-          );
-          assert(ftr.valid());
-        } else 
-#endif
-          prtcls->step_async(params.cloudph_opts);
+        // opts passed by value as set_rain() may alter them while step_async() is running
+        const libcloudphxx::lgrngn::opts_t<real_t> opts = params.cloudph_opts;
+        auto *p = prtcls.get();
+        worker->submit([p, opts]{ p->step_async(opts); });
+      } 
+      else
+      {
+        scoped_timer tmr(this->timers(), "step_async");
+        prtcls->step_async(params.cloudph_opts);
       }
 
       // performing diagnostics
       if (this->timestep % this->outfreq == 0) 
       { 
-#if defined(STD_FUTURE_WORKS)
-        if (params.async)
+        if (worker)
         {
-          assert(ftr.valid());
-          ftr.get();
+          scoped_timer tmr(this->timers(), "step_async_wait");
+          worker->wait();
         }
-#endif
         diag();
       }
     }
 
-    this->mem->barrier();
+    this->timed_barrier();
+
+    // of the fields as adjusted by step_sync() above
+    this->reduce();
+
+    if (this->timestep == this->nt_end && this->rank == 0) 
+    {
+      // the last step_async() completed, any exception from it thrown here (not lost when the worker is joined)
+      if (worker) worker->wait();
+      this->finish_output(); // including the above diag() and reduce() output
+    }
   }
 
   public:
@@ -222,6 +352,7 @@ class kin_cloud_2d_lgrngn : public kin_cloud_2d_common<ct_params_t>
     libcloudphxx::lgrngn::opts_t<real_t> cloudph_opts;
     libcloudphxx::lgrngn::opts_init_t<real_t> cloudph_opts_init;
     outmom_t<real_t> out_dry, out_wet;
+    bool out_spec_compact = false; // see record_spec_compact()
   };
 
   private:
@@ -239,6 +370,7 @@ class kin_cloud_2d_lgrngn : public kin_cloud_2d_common<ct_params_t>
     parent_t(args, p),
     params(p)
   {
+    this->reduce_in_hooks = false; // see hook_ante_loop() and hook_post_step()
     // delaying any initialisation to ante_loop as rank() does not function within ctor! // TODO: not anymore!!!
     // TODO: equip rank() in libmpdata with an assert() checking if not in serial block
   }  
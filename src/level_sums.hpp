@@ -0,0 +1,48 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+// per-level sums over the whole domain of any number of fields at once (e.g.
+// for the horizontal means used by the relaxation terms): each thread adds
+// up its own columns into its slot and, after a single barrier, each one
+// combines all the slots itself; the slots are double-buffered (the calls
+// alternating between the two), so that a thread starting the next call
+// does not overwrite the partials of the previous one while the others may
+// still be reading them; shared among threads through rt_params (as timing_t)
+class level_sums_t
+{
+  std::mutex mtx;
+  std::map<int, std::vector<double>> slots[2]; // by rank (references to the elements stay valid)
+
+  public:
+
+  // allocating the slots of a thread, to be followed by a barrier before the first use
+  void init(const int rank, const int n)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto &s : slots) s[rank].assign(n, 0);
+  }
+
+  // this thread's slot in the buffer of a given parity
+  std::vector<double> &slot(const int rank, const int parity)
+  {
+    return slots[parity].at(rank);
+  }
+
+  // the slots of all threads summed up (after a barrier following the writes)
+  void combine(const int parity, std::vector<double> &sum) const
+  {
+    sum.assign(slots[parity].begin()->second.size(), 0);
+    for (auto &s : slots[parity])
+      for (int k = 0; k < sum.size(); ++k) sum[k] += s.second[k];
+  }
+};
@@ -29,6 +29,7 @@ void setopts_micro(
     ("conv", po::value<bool>()->default_value(rt_params.cloudph_opts.conv) , "autoconversion of cloud water into rain (1=on, 0=off)")
     ("accr", po::value<bool>()->default_value(rt_params.cloudph_opts.accr) , "cloud water collection by rain (1=on, 0=off)")
     ("sedi", po::value<bool>()->default_value(rt_params.cloudph_opts.sedi) , "rain water sedimentation (1=on, 0=off)")
+    ("adj", po::value<std::string>()->default_value("scalar"), "saturation adjustment: scalar (libcloudph++), simd (Newton, vectorised) or simd_skip (ditto, skipping subsaturated cells with no condensate)")
 //TODO: autoconv_threshold, epsilon
   ;
   po::variables_map vm;
@@ -42,6 +43,21 @@ void setopts_micro(
   rt_params.cloudph_opts.accr = vm["accr"].as<bool>();
   rt_params.cloudph_opts.sedi = vm["sedi"].as<bool>();
 
+  // saturation adjustment kernel
+  std::string adj = vm["adj"].as<std::string>();
+  if (adj == "scalar") rt_params.adj = adj_t::scalar;
+  else if (adj == "simd") rt_params.adj = adj_t::simd;
+  else if (adj == "simd_skip") rt_params.adj = adj_t::simd_skip;
+  else BOOST_THROW_EXCEPTION(po::validation_error(
+    po::validation_error::invalid_option_value, "adj", adj
+  ));
+
+  // the SIMD adjustment being the only place where acc_t differs from real_t (see --precision)
+  if (!std::is_same<typename solver_t::real_t, typename solver_t::acc_t>::value && rt_params.adj == adj_t::scalar) 
+    BOOST_THROW_EXCEPTION(po::validation_error(
+      po::validation_error::invalid_option_value, "precision", "mixed (supported with --adj=simd or simd_skip only)"
+    ));
+
   // output variables
   rt_params.outvars = {
     // <TODO>: make it common among all three micro?
@@ -12,26 +12,180 @@
 #include <boost/program_options/variables_map.hpp>
 #include <boost/program_options/parsers.hpp>
 namespace po = boost::program_options;
+#include <boost/throw_exception.hpp>
+
+#include "h5_writer.hpp"
+#include "reductions.hpp"
+
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 // some globals for option handling
 int ac; 
 char** av; // TODO: write it down to a file as in icicle ... write the default (i.e. not specified) values as well!
 po::options_description opts_main("General options"); 
+po::variables_map vm_all; // all options (incl. micro-specific ones and defaults) as parsed by handle_opts()
 
 void handle_opts(
   po::options_description &opts_micro,
   po::variables_map &vm 
 )
 {
-  opts_main.add(opts_micro);
-  po::store(po::parse_command_line(ac, av, opts_main), vm); // could be exchanged with a config file parser
+  // working on a copy so that the parsing can be repeated (e.g. by the in-process benchmarks)
+  po::options_description opts_all(opts_main);
+  opts_all.add(opts_micro);
+  po::store(po::parse_command_line(ac, av, opts_all), vm); // could be exchanged with a config file parser
 
   // hendling the "help" option
   if (vm.count("help"))
   {
-    std::cout << opts_main;
+    std::cout << opts_all;
     exit(EXIT_SUCCESS);
   }
   po::notify(vm); // includes checks for required options
+
+  vm_all = vm;
+}
+
+// canonical "name=value;..." representation of the option values (in alphabetical 
+// order, with the defaults) skipping the ones listed in ignored
+std::string opts_key(
+  const po::variables_map &vm, 
+  const std::set<std::string> &ignored
+)
+{
+  std::ostringstream key;
+  key << std::setprecision(std::numeric_limits<double>::max_digits10);
+  for (auto &opt : vm)
+  {
+    if (ignored.count(opt.first)) continue;
+    const boost::any &val = opt.second.value();
+    key << opt.first << "=";
+    if (auto v = boost::any_cast<std::string>(&val)) key << *v;
+    else if (auto v = boost::any_cast<bool>(&val)) key << *v;
+    else if (auto v = boost::any_cast<int>(&val)) key << *v;
+    else if (auto v = boost::any_cast<float>(&val)) key << *v;
+    else if (auto v = boost::any_cast<double>(&val)) key << *v;
+    else throw std::logic_error("opts_key(): unsupported type of option " + opt.first);
+    key << ";";
+  }
+  return key.str();
+}
+
+
+// storage filters of the output as set with --out_chunk, --out_deflate and --out_keepbits
+h5_filters_t out_filters(const po::variables_map &vm)
+{
+  h5_filters_t ret;
+
+  // "X,Z"
+  if (vm.count("out_chunk"))
+  {
+    const std::string val = vm["out_chunk"].as<std::string>();
+    std::istringstream iss(val);
+    int x = 0, z = 0;
+    char sep = 0;
+    if (!(iss >> x >> sep >> z) || sep != ',' || x < 1 || z < 1 || !(iss >> std::ws).eof()) 
+      BOOST_THROW_EXCEPTION(po::validation_error(po::validation_error::invalid_option_value, "out_chunk", val));
+    ret.chunk = {hsize_t(x), hsize_t(z)};
+  }
+
+  ret.deflate = vm["out_deflate"].as<int>();
+  if (ret.deflate < 0 || ret.deflate > 9) BOOST_THROW_EXCEPTION(po::validation_error(
+    po::validation_error::invalid_option_value, "out_deflate", std::to_string(ret.deflate)
+  ));
+
+  // "prefix:bits,prefix:bits,..." with "*" matching all fields
+  const std::string val = vm["out_keepbits"].as<std::string>();
+  std::istringstream iss(val);
+  std::string item;
+  while (std::getline(iss, item, ','))
+  {
+    const auto sep = item.rfind(':');
+    std::istringstream bits_ss(sep == std::string::npos ? "" : item.substr(sep + 1));
+    int bits = -1;
+    if (!(bits_ss >> bits) || !bits_ss.eof() || bits < 0 || bits >= std::numeric_limits<float>::digits) 
+      BOOST_THROW_EXCEPTION(po::validation_error(po::validation_error::invalid_option_value, "out_keepbits", val));
+    const std::string prefix = item.substr(0, sep);
+    ret.keepbits[prefix == "*" ? "" : prefix] = bits;
+  }
+
+  return ret;
 }
 
+// per-variable output intervals as set with --out_sched, by variable-name prefix
+// (the longest matching one applies, "" matching all, 0 meaning never)
+std::map<std::string, int> out_sched(const po::variables_map &vm, const int outfreq)
+{
+  std::map<std::string, int> ret;
+
+  // "prefix:freq,prefix:freq,..." with "*" matching all variables
+  const std::string val = vm["out_sched"].as<std::string>();
+  std::istringstream iss(val);
+  std::string item;
+  while (std::getline(iss, item, ','))
+  {
+    const auto sep = item.rfind(':');
+    std::istringstream freq_ss(sep == std::string::npos ? "" : item.substr(sep + 1));
+    int freq = -1;
+    if (!(freq_ss >> freq) || !freq_ss.eof() || freq < 0 || freq % outfreq != 0) 
+      BOOST_THROW_EXCEPTION(po::validation_error(po::validation_error::invalid_option_value, "out_sched", val));
+    const std::string prefix = item.substr(0, sep);
+    ret[prefix == "*" ? "" : prefix] = freq;
+  }
+
+  return ret;
+}
+
+// the relaxation timescale profile as set with --relax
+std::vector<std::pair<double, double>> relax_tau(const po::variables_map &vm)
+{
+  std::vector<std::pair<double, double>> ret;
+
+  // "z:tau,z:tau,..." with z ascending
+  const std::string val = vm["relax"].as<std::string>();
+  std::istringstream iss(val);
+  std::string item;
+  while (std::getline(iss, item, ','))
+  {
+    std::istringstream item_ss(item);
+    double z = 0, tau = 0;
+    char sep = 0;
+    if (!(item_ss >> z >> sep >> tau) || sep != ':' || tau <= 0 || !(item_ss >> std::ws).eof() || (!ret.empty() && z <= ret.back().first))
+      BOOST_THROW_EXCEPTION(po::validation_error(po::validation_error::invalid_option_value, "relax", val));
+    ret.push_back({z, tau});
+  }
+
+  return ret;
+}
+
+// the in-situ reductions as set with --diag and --diag_freq (nullptr if none)
+std::shared_ptr<reductions_t> reductions(const po::variables_map &vm)
+{
+  // "name,name,..."
+  const std::string val = vm["diag"].as<std::string>();
+  std::set<std::string> vars;
+  std::istringstream iss(val);
+  std::string item;
+  while (std::getline(iss, item, ','))
+  {
+    if (!reductions_t::known().count(item)) 
+      BOOST_THROW_EXCEPTION(po::validation_error(po::validation_error::invalid_option_value, "diag", val));
+    vars.insert(item);
+  }
+  if (vars.empty()) return nullptr;
+
+  const int freq = vm["diag_freq"].as<int>();
+  if (freq < 1) BOOST_THROW_EXCEPTION(po::validation_error(
+    po::validation_error::invalid_option_value, "diag_freq", std::to_string(freq)
+  ));
+
+  return std::make_shared<reductions_t>(vars, freq);
+}
@@ -28,12 +28,13 @@ void setopts_micro(
   >::value>::type* = 0
 )
 {
-  using thrust_real_t = setup::real_t; // TODO: make it a choice?
+  using thrust_real_t = typename solver_t::real_t; // i.e. as chosen with --precision
 
   po::options_description opts("Lagrangian microphysics options"); 
   opts.add_options()
     ("backend", po::value<std::string>()->required() , "one of: CUDA, OpenMP, serial")
-    ("async", po::value<bool>()->default_value(true), "use CPU for advection while GPU does micro (ignored if backend != CUDA)")
+    ("async", po::value<bool>()->default_value(true), "run particle micro concurrently with the next advection step (by default with CUDA only, on CPU backends if set explicitly, see also --threads_micro)")
+    ("threads_micro", po::value<int>()->default_value(0), "OpenMP threads for particle micro (0 -> as many as advection threads, advection threads set with --threads_adv, see also --pin)")
     ("sd_conc_mean", po::value<thrust_real_t>()->required() , "mean super-droplet concentration per grid cell (int)")
     // processes
     ("adve", po::value<bool>()->default_value(rt_params.cloudph_opts.adve) , "particle advection     (1=on, 0=off)")
@@ -48,6 +49,7 @@ void setopts_micro(
     // 
     ("out_dry", po::value<std::string>()->default_value("0:1|0"),       "dry radius ranges and moment numbers (r1:r2|n1,n2...;...)")
     ("out_wet", po::value<std::string>()->default_value(".5e-6:25e-6|0,1,2,3;25e-6:1|0,3,6"),  "wet radius ranges and moment numbers (r1:r2|n1,n2...;...)")
+    ("out_spec", po::value<std::string>()->default_value("separate"), "layout of the --out_dry/--out_wet output: separate (a 2-D dataset per range and moment) or compact (a (range, moment, x, z) dataset per sequence of ranges with the same moments)")
     // TODO: MAC, HAC, vent_coef
   ;
   po::variables_map vm;
@@ -58,7 +60,20 @@ void setopts_micro(
   else if (backend_str == "OpenMP") rt_params.backend = libcloudphxx::lgrngn::OpenMP;
   else if (backend_str == "serial") rt_params.backend = libcloudphxx::lgrngn::serial;
 
-  rt_params.async = vm["async"].as<bool>();
+  // on CPU backends only if asked for (sharing the cores with advection, see --threads_micro)
+  rt_params.async = vm["async"].as<bool>() && (backend_str == "CUDA" || !vm["async"].defaulted());
+  // the team size itself is passed in rt_params.threads (see icicle.cpp)
+  const int threads_micro = vm["threads_micro"].as<int>();
+  if (threads_micro < 0) BOOST_THROW_EXCEPTION(po::validation_error(
+    po::validation_error::invalid_option_value, "threads_micro", std::to_string(threads_micro)
+  ));
+
+  const std::string out_spec = vm["out_spec"].as<std::string>();
+  if (out_spec != "separate" && out_spec != "compact") BOOST_THROW_EXCEPTION(po::validation_error(
+    po::validation_error::invalid_option_value, "out_spec", out_spec
+  ));
+  rt_params.out_spec_compact = out_spec == "compact";
+  if (rt_params.out_spec_compact) rt_params.out_own = true; // written via record_aux_nd()
 
   rt_params.cloudph_opts_init.sd_conc_mean = vm["sd_conc_mean"].as<thrust_real_t>();;
   rt_params.cloudph_opts_init.nx = nx;
@@ -124,12 +139,12 @@ void setopts_micro(
     {
       int sep = ss.second.find('|'); 
 
-      moms.push_back(outmom_t<thrust_real_t>::value_type({
-        outmom_t<thrust_real_t>::value_type::first_type(
-          boost::lexical_cast<setup::real_t>(ss.first) * si::metres,
-          boost::lexical_cast<setup::real_t>(ss.second.substr(0, sep)) * si::metres
+      moms.push_back(typename outmom_t<thrust_real_t>::value_type({
+        typename outmom_t<thrust_real_t>::value_type::first_type(
+          boost::lexical_cast<thrust_real_t>(ss.first) * si::metres,
+          boost::lexical_cast<thrust_real_t>(ss.second.substr(0, sep)) * si::metres
         ), 
-        outmom_t<setup::real_t>::value_type::second_type()
+        typename outmom_t<thrust_real_t>::value_type::second_type()
       }));
 
       // TODO catch (boost::bad_lexical_cast &)
@@ -14,4 +14,13 @@ using outmom_t = std::list<
   >
 >;
 
+// number of (range, moment) pairs, i.e. the leading dimension of the spectral buffers
+template <typename real_t>
+int outmom_size(const outmom_t<real_t> &moms)
+{
+  int n = 0;
+  for (auto &rng_moms : moms) n += rng_moms.second.size();
+  return n;
+}
+
 // TODO: option parsing code should go here...
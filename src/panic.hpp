@@ -10,11 +10,17 @@
 #  include <signal.h>
 #endif
 
-bool *panic;
+#include <set>
+#include <vector>
+
+// note: the flag makes the solvers leave the timestepping loop; the 
+//       output still pending with --out_async is then flushed when the
+//       solvers are destroyed (nothing else is done within the handler)
+std::vector<bool*> panic; // one flag per solver (more than one with --ensemble)
 
 void panic_handler(int)
 {
-  *panic = true;
+  for (auto p : panic) *p = true;
 }
 
 void set_sigaction()
@@ -0,0 +1,67 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// in-situ reductions (see --diag): domain and column statistics computed every
+// freq timesteps by all threads, each one reducing its own columns into its slot
+// of partials (in double precision), the slots being combined by rank 0 and the
+// results appended to outdir/diag.h5 (see kin_cloud_2d_common::reduce());
+// shared among threads through rt_params (as timing_t)
+class reductions_t
+{
+  std::mutex mtx;
+  std::map<int, std::vector<double>> per_rank; // (references to the elements stay valid)
+
+  public:
+
+  // the quantities available
+  static const std::set<std::string> &known()
+  {
+    static const std::set<std::string> ret({"lwp", "rwp", "cloud_cover", "precip", "smax", "prof"});
+    return ret;
+  }
+
+  const std::set<std::string> vars;
+  const int freq;
+
+  reductions_t(const std::set<std::string> &vars, const int freq) : vars(vars), freq(freq) {}
+
+  bool on(const std::string &var) const
+  {
+    return vars.count(var) != 0;
+  }
+
+  // this thread's n partials, zeroed
+  std::vector<double> &slot(const int rank, const int n)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto &ret = per_rank[rank];
+    ret.assign(n, 0);
+    return ret;
+  }
+
+  // the slots of all threads summed up, except for the entries listed in at_max
+  // (combined by taking the maximum); to be called by one thread after a barrier
+  std::vector<double> combine(const std::set<int> &at_max)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<double> ret(per_rank.begin()->second);
+    for (auto it = std::next(per_rank.begin()); it != per_rank.end(); ++it)
+      for (int k = 0; k < ret.size(); ++k)
+        ret[k] = at_max.count(k) ? std::max(ret[k], it->second[k]) : ret[k] + it->second[k];
+    return ret;
+  }
+};
@@ -0,0 +1,148 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <libcloudph++/blk_1m/options.hpp>
+#include <libcloudph++/blk_1m/rhs_cellwise.hpp>
+#include <libcloudph++/blk_1m/rhs_columnwise.hpp>
+
+#include <libcloudph++/blk_2m/options.hpp>
+#include <libcloudph++/blk_2m/rhs_cellwise.hpp>
+#include <libcloudph++/blk_2m/rhs_columnwise.hpp>
+
+// bulk-microphysics rhs evaluated column by column: the cell-wise and the
+// column-wise (sedimentation) terms are computed one after another for
+// a given column, i.e. while it is still in cache (instead of two sweeps
+// over the whole subdomain); the columns are the (ii, j) slices, contiguous
+// in memory, and only the columns within the i range are read or written
+// (hence no synchronisation is needed if each thread has its own i range)
+
+// the process toggles as a template parameter: a bit mask of the processes
+// switched on (overriding the ones in opts) or procs_rt for checking the ones
+// in opts at run time; with a mask the toggles are compile-time constants
+// and, the libcloudph++ kernels being header-only templates, the compiler can
+// fold the per-cell branches on them (and the calls with no process on are 
+// not made at all)
+enum : int { procs_rt = -1 };
+
+namespace procs_blk_1m 
+{
+  enum : int { conv = 1 << 0, accr = 1 << 1, sedi = 1 << 2 };
+
+  template <typename real_t>
+  int mask(const libcloudphxx::blk_1m::opts_t<real_t> &opts)
+  {
+    return (opts.conv ? conv : 0) | (opts.accr ? accr : 0) | (opts.sedi ? sedi : 0);
+  }
+}
+
+namespace procs_blk_2m 
+{
+  enum : int { acti = 1 << 0, cond = 1 << 1, acnv = 1 << 2, accr = 1 << 3, sedi = 1 << 4 };
+
+  template <typename real_t>
+  int mask(const libcloudphxx::blk_2m::opts_t<real_t> &opts)
+  {
+    return 
+      (opts.acti ? acti : 0) | (opts.cond ? cond : 0) | 
+      (opts.acnv ? acnv : 0) | (opts.accr ? accr : 0) | (opts.sedi ? sedi : 0);
+  }
+}
+
+template <int procs = procs_rt, typename real_t, class arr_t, class rng_t>
+void rhs_fused_blk_1m(
+  const libcloudphxx::blk_1m::opts_t<real_t> &opts_rt,
+  arr_t &dot_rc, arr_t &dot_rr,
+  const arr_t &rhod, const arr_t &rc, const arr_t &rr,
+  const rng_t &i, const rng_t &j,
+  const real_t &dz
+)
+{
+  using namespace procs_blk_1m;
+
+  libcloudphxx::blk_1m::opts_t<real_t> opts(opts_rt);
+  if (procs != procs_rt)
+  {
+    opts.conv = procs & conv;
+    opts.accr = procs & accr;
+    opts.sedi = procs & sedi;
+  }
+  const bool 
+    cellwise   = procs == procs_rt || (procs & (conv | accr)),
+    columnwise = procs == procs_rt || (procs & sedi);
+
+  for (int ii = i.first(); ii <= i.last(); ++ii)
+  {
+    auto
+      dot_rc_c = dot_rc(ii, j),
+      dot_rr_c = dot_rr(ii, j);
+    const auto
+      rhod_c   = rhod(ii, j),
+      rc_c     = rc(ii, j),
+      rr_c     = rr(ii, j);
+
+    if (cellwise)   libcloudphxx::blk_1m::rhs_cellwise<real_t>(opts, dot_rc_c, dot_rr_c, rc_c, rr_c);
+    if (columnwise) libcloudphxx::blk_1m::rhs_columnwise<real_t>(opts, dot_rr_c, rhod_c, rr_c, dz);
+  }
+}
+
+template <int procs = procs_rt, typename real_t, class arr_t, class rng_t>
+void rhs_fused_blk_2m(
+  const libcloudphxx::blk_2m::opts_t<real_t> &opts_rt,
+  arr_t &dot_th, arr_t &dot_rv, arr_t &dot_rc, arr_t &dot_nc, arr_t &dot_rr, arr_t &dot_nr,
+  const arr_t &rhod, const arr_t &th, const arr_t &rv, const arr_t &rc, const arr_t &nc, const arr_t &rr, const arr_t &nr,
+  const rng_t &i, const rng_t &j,
+  const real_t &dt, const real_t &dz
+)
+{
+  using namespace procs_blk_2m;
+
+  libcloudphxx::blk_2m::opts_t<real_t> opts(opts_rt);
+  if (procs != procs_rt)
+  {
+    opts.acti = procs & acti;
+    opts.cond = procs & cond;
+    opts.acnv = procs & acnv;
+    opts.accr = procs & accr;
+    opts.sedi = procs & sedi;
+  }
+  const bool 
+    cellwise   = procs == procs_rt || (procs & (acti | cond | acnv | accr)),
+    columnwise = procs == procs_rt || (procs & sedi);
+
+  for (int ii = i.first(); ii <= i.last(); ++ii)
+  {
+    auto
+      dot_th_c = dot_th(ii, j),
+      dot_rv_c = dot_rv(ii, j),
+      dot_rc_c = dot_rc(ii, j),
+      dot_nc_c = dot_nc(ii, j),
+      dot_rr_c = dot_rr(ii, j),
+      dot_nr_c = dot_nr(ii, j);
+    const auto
+      rhod_c   = rhod(ii, j),
+      th_c     = th(ii, j),
+      rv_c     = rv(ii, j),
+      rc_c     = rc(ii, j),
+      nc_c     = nc(ii, j),
+      rr_c     = rr(ii, j),
+      nr_c     = nr(ii, j);
+
+    if (cellwise) libcloudphxx::blk_2m::rhs_cellwise<real_t>(
+      opts, dot_th_c, dot_rv_c, dot_rc_c, dot_nc_c, dot_rr_c, dot_nr_c,
+      rhod_c,   th_c,     rv_c,     rc_c,     nc_c,     rr_c,     nr_c,
+      dt
+    );
+    if (columnwise) libcloudphxx::blk_2m::rhs_columnwise<real_t>(
+      opts, dot_rr_c, dot_nr_c,
+      rhod_c,   rr_c,     nr_c,
+      dt,
+      dz
+    );
+  }
+}
@@ -0,0 +1,266 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+// runs a set of icicle simulations concurrently; the job file lists
+// the icicle options of one run per line (empty lines and lines starting
+// with # are ignored); each job gets --threads cores (its OMP_NUM_THREADS
+// and, on Linux, its CPU affinity); the jobs are dealt to per-worker deques
+// in the order of decreasing estimated cost and idle workers steal the
+// most expensive job left from the others; a job is skipped if its outdir contains a sweep.hash file
+// matching its options (written after a successful run)
+
+#include <boost/program_options.hpp>
+#include <boost/exception/all.hpp>
+namespace po = boost::program_options;
+
+#include "hash.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__linux__)
+#  include <sched.h>
+#endif
+
+struct job_t
+{
+  std::string opts, outdir, hash;
+  double cost;
+};
+
+// the --key=value options of a job (other tokens ignored)
+std::map<std::string, std::string> parse(const std::string &opts)
+{
+  std::map<std::string, std::string> ret;
+  std::istringstream iss(opts);
+  std::string tok;
+  while (iss >> tok)
+  {
+    if (tok.compare(0, 2, "--") != 0) continue;
+    const auto sep = tok.find('=');
+    ret[tok.substr(2, sep == std::string::npos ? sep : sep - 2)] =
+      sep == std::string::npos ? "" : tok.substr(sep + 1);
+  }
+  return ret;
+}
+
+// a rough estimate of the run time (only the ordering matters)
+double cost(const std::map<std::string, std::string> &kv)
+{
+  auto get = [&](const std::string &key, double def)
+  {
+    auto it = kv.find(key);
+    return it == kv.end() ? def : std::stod(it->second);
+  };
+  double ret = get("nx", 76) * get("nz", 76) * get("nt", 3600);
+  auto micro = kv.find("micro");
+  if (micro != kv.end())
+  {
+    if (micro->second == "blk_2m") ret *= 2;
+    if (micro->second == "lgrngn") ret *= 10 * std::max(1., get("sd_conc_mean", 1));
+  }
+  return ret;
+}
+
+// the options with the tokens sorted (i.e. independent of the order)
+std::string key(const std::string &opts)
+{
+  std::vector<std::string> toks;
+  std::istringstream iss(opts);
+  std::string tok;
+  while (iss >> tok) toks.push_back(tok);
+  std::sort(toks.begin(), toks.end());
+  std::ostringstream ret;
+  for (auto &t : toks) ret << t << " ";
+  return ret.str();
+}
+
+bool done(const job_t &job)
+{
+  std::ifstream ifs(job.outdir + "/sweep.hash");
+  std::string hash;
+  return ifs >> hash && hash == job.hash;
+}
+
+class sweep_t
+{
+  std::vector<std::deque<job_t>> deques;
+  std::vector<std::mutex> mtxs;
+  std::mutex log_mtx;
+
+  const std::string icicle;
+  const int threads;
+  int n_fail = 0;
+
+  void log(const std::string &msg)
+  {
+    std::lock_guard<std::mutex> lock(log_mtx);
+    std::cerr << " info: " << msg << std::endl;
+  }
+
+  // own deque first, then stealing; the most expensive job left in either case
+  // (so that the longest runs start as early as possible and the cheap ones fill the gaps)
+  bool next(const int w, job_t &job)
+  {
+    for (int k = 0; k < deques.size(); ++k)
+    {
+      const int v = (w + k) % deques.size();
+      std::lock_guard<std::mutex> lock(mtxs[v]);
+      if (deques[v].empty()) continue;
+      job = deques[v].front();
+      deques[v].pop_front();
+      return true;
+    }
+    return false;
+  }
+
+  bool exec(const int w, const job_t &job)
+  {
+    std::ostringstream cmd;
+    cmd << "OMP_NUM_THREADS=" << threads << " exec " << icicle << " " << job.opts;
+    const std::string cmd_str = cmd.str(); // not allocating after fork()
+    const int n_cpu = std::max(1u, std::thread::hardware_concurrency());
+
+    const pid_t pid = fork();
+    if (pid == -1) return false;
+    if (pid == 0)
+    {
+#if defined(__linux__)
+      // worker w runs on cores [w * threads, (w + 1) * threads) (wrapped around if oversubscribed)
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int c = w * threads; c < (w + 1) * threads; ++c) CPU_SET(c % n_cpu, &set);
+      sched_setaffinity(0, sizeof(set), &set);
+#endif
+      execl("/bin/sh", "sh", "-c", cmd_str.c_str(), (char*)NULL);
+      _exit(127);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) == -1) return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+  }
+
+  void work(const int w)
+  {
+    job_t job;
+    while (next(w, job))
+    {
+      if (!job.outdir.empty() && done(job))
+      {
+        log("skipping (already done): " + job.opts);
+        continue;
+      }
+
+      log("about to run: " + job.opts);
+      if (exec(w, job))
+      {
+        if (!job.outdir.empty()) std::ofstream(job.outdir + "/sweep.hash") << job.hash << std::endl;
+        log("done: " + job.opts);
+      }
+      else
+      {
+        log("failed: " + job.opts);
+        std::lock_guard<std::mutex> lock(log_mtx);
+        n_fail++;
+      }
+    }
+  }
+
+  public:
+
+  sweep_t(std::vector<job_t> jobs, const int n_workers, const std::string &icicle, const int threads) :
+    deques(n_workers),
+    mtxs(n_workers),
+    icicle(icicle),
+    threads(threads)
+  {
+    std::stable_sort(jobs.begin(), jobs.end(), [](const job_t &a, const job_t &b) { return a.cost > b.cost; });
+    for (int j = 0; j < jobs.size(); ++j) deques[j % n_workers].push_back(jobs[j]);
+  }
+
+  int run()
+  {
+    std::vector<std::thread> workers;
+    for (int w = 0; w < deques.size(); ++w) workers.emplace_back(&sweep_t::work, this, w);
+    for (auto &w : workers) w.join();
+    return n_fail;
+  }
+};
+
+int main(int ac, char** av)
+{
+  try
+  {
+    po::options_description opts("Sweep options");
+    opts.add_options()
+      ("jobfile", po::value<std::string>()->required(), "file with icicle options, one run per line")
+      ("icicle", po::value<std::string>()->default_value("icicle"), "icicle executable")
+      ("threads", po::value<int>()->default_value(1), "threads (cores) per job")
+      ("workers", po::value<int>()->default_value(0), "max. number of concurrent jobs (0 -> cores / threads)")
+      ("help", "produce a help message")
+    ;
+    po::positional_options_description pos;
+    pos.add("jobfile", 1);
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(ac, av).options(opts).positional(pos).run(), vm);
+    if (ac == 1 || vm.count("help"))
+    {
+      std::cout << "usage: sweep [options] jobfile" << std::endl << opts;
+      exit(EXIT_SUCCESS);
+    }
+    po::notify(vm);
+
+    const int threads = vm["threads"].as<int>();
+    if (threads < 1) BOOST_THROW_EXCEPTION(po::validation_error(
+      po::validation_error::invalid_option_value, "threads", std::to_string(threads)
+    ));
+    int n_workers = vm["workers"].as<int>();
+    if (n_workers == 0) n_workers = std::max(1, int(std::thread::hardware_concurrency()) / threads);
+
+    // reading the job file
+    std::vector<job_t> jobs;
+    std::ifstream ifs(vm["jobfile"].as<std::string>());
+    if (!ifs) throw std::runtime_error("failed to open " + vm["jobfile"].as<std::string>());
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+      if (line.find_first_not_of(" \t") == std::string::npos || line[line.find_first_not_of(" \t")] == '#') continue;
+      const auto kv = parse(line);
+      job_t job;
+      job.opts = line;
+      job.outdir = kv.count("outdir") ? kv.at("outdir") : "";
+      job.hash = fnv1a_hex(key(line));
+      job.cost = cost(kv);
+      jobs.push_back(job);
+    }
+
+    const int n_fail = sweep_t(jobs, std::min(n_workers, std::max(1, int(jobs.size()))), vm["icicle"].as<std::string>(), threads).run();
+    if (n_fail != 0)
+    {
+      std::cerr << "error: " << n_fail << " job(s) failed" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  catch (std::exception &e)
+  {
+    std::cerr << boost::current_exception_diagnostic_information();
+    exit(EXIT_FAILURE);
+  }
+}
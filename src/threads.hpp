@@ -0,0 +1,137 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <H5Cpp.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#  include <sched.h>
+#endif
+
+// the cores this process may run on (e.g. as restricted by a batch system or cgroups), 
+// all the cores if not known
+inline std::vector<int> allowed_cpus()
+{
+  std::vector<int> ret;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    for (int c = 0; c < CPU_SETSIZE; ++c) if (CPU_ISSET(c, &set)) ret.push_back(c);
+#endif
+  if (ret.empty())
+    for (int c = 0; c < int(std::max(1u, std::thread::hardware_concurrency())); ++c) ret.push_back(c);
+  return ret;
+}
+
+// the thread budget of a run (or of an ensemble member) and its placement on the cores
+// (see --threads_adv, --threads_micro and --pin): the advection threads (libmpdata++'s ones,
+// one per rank) are pinned one per core, the particle-microphysics OpenMP team is confined
+// to its own cores (the team's threads inherit the affinity of the thread creating it)
+struct thread_layout_t
+{
+  int adv = 0, micro = 0;           // thread counts (micro: 0 -> no separate team)
+  std::string pin = "none";         // compact, scatter, none or a list of core numbers
+  std::vector<int> cpus_adv, cpus_micro; // empty -> not pinned
+
+  // the cores of member m of n_memb out of the allowed ones given the policy: compact 
+  // (consecutive cores, the members one after another), scatter (spread evenly over 
+  // all the cores, e.g. over the sockets), or an explicit list (split into consecutive 
+  // slices of adv + micro cores, one per member, the advection threads' cores first)
+  void place(const int m, const int n_memb)
+  {
+    cpus_adv.clear();
+    cpus_micro.clear();
+    if (pin == "none") return;
+
+    const std::vector<int> avail = allowed_cpus();
+    const int n_cpu = avail.size(), n = adv + micro;
+    std::vector<int> cpus;
+    if (pin == "compact")
+      for (int k = 0; k < n; ++k) cpus.push_back(avail[(m * n + k) % n_cpu]);
+    else if (pin == "scatter")
+    {
+      const int stride = std::max(1, n_cpu / (n_memb * n));
+      for (int k = 0; k < n; ++k) cpus.push_back(avail[((m * n + k) * stride) % n_cpu]);
+    }
+    else
+    {
+      std::istringstream iss(pin);
+      std::string item;
+      std::vector<int> list;
+      while (std::getline(iss, item, ',')) list.push_back(std::stoi(item));
+      if (int(list.size()) < (n_memb - 1) * n + adv) throw std::invalid_argument("fewer cores listed than advection threads (of all the ensemble members)");
+      cpus.assign(list.begin() + m * n, list.begin() + std::min(int(list.size()), (m + 1) * n));
+    }
+
+    cpus_adv.assign(cpus.begin(), cpus.begin() + adv);
+    cpus_micro.assign(cpus.begin() + adv, cpus.begin() + std::min(int(cpus.size()), n));
+  }
+
+  std::string str() const
+  {
+    std::ostringstream os;
+    os << adv << " advection thread(s)";
+    if (micro > 0) os << ", " << micro << " microphysics thread(s)";
+    os << ", pinning: " << pin;
+    return os.str();
+  }
+};
+
+// restricting the calling thread to a set of cores (a no-op if empty or not on Linux);
+// a failure (e.g. none of the cores allowed) is reported and the thread left as it was
+inline void pin_thread(const std::vector<int> &cpus)
+{
+#if defined(__linux__)
+  if (cpus.empty()) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto &c : cpus) if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+  if (sched_setaffinity(0, sizeof(set), &set) != 0)
+  {
+    std::ostringstream os;
+    os << "warning: failed to pin a thread to core(s)";
+    for (auto &c : cpus) os << " " << c;
+    os << ": " << std::strerror(errno) << std::endl;
+    std::cerr << os.str();
+  }
+#endif
+}
+
+// the layout recorded as attributes of the root group of a new file (e.g. outdir/threads.h5)
+inline void record_layout(const std::string &file, const thread_layout_t &layout)
+{
+  H5::H5File h5f(file, H5F_ACC_TRUNC);
+  H5::Group root = h5f.openGroup("/");
+
+  const int n_threads[2] = {layout.adv, layout.micro};
+  const hsize_t two = 2;
+  root.createAttribute("threads_adv_micro", H5::PredType::NATIVE_INT, H5::DataSpace(1, &two))
+    .write(H5::PredType::NATIVE_INT, n_threads);
+
+  H5::StrType strtype(H5::PredType::C_S1, std::max(size_t(1), layout.pin.size()));
+  root.createAttribute("pin", strtype, H5::DataSpace(H5S_SCALAR)).write(strtype, layout.pin);
+
+  for (auto &cpus : {std::make_pair("cpus_adv", &layout.cpus_adv), std::make_pair("cpus_micro", &layout.cpus_micro)})
+  {
+    if (cpus.second->empty()) continue;
+    const hsize_t n = cpus.second->size();
+    root.createAttribute(cpus.first, H5::PredType::NATIVE_INT, H5::DataSpace(1, &n))
+      .write(H5::PredType::NATIVE_INT, cpus.second->data());
+  }
+}
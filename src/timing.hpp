@@ -0,0 +1,158 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// per-thread wall-clock accumulators (nested calls to the same timer are counted once)
+class timers_t
+{
+  using clock = std::chrono::steady_clock;
+
+  struct tmr_t
+  {
+    double sec = 0;
+    long cnt = 0;
+    int depth = 0;
+    clock::time_point t0;
+  };
+
+  std::map<std::string, tmr_t> tmrs;
+
+  public:
+
+  void start(const std::string &name)
+  {
+    auto &t = tmrs[name];
+    if (t.depth++ == 0) t.t0 = clock::now();
+  }
+
+  void stop(const std::string &name)
+  {
+    auto &t = tmrs[name];
+    assert(t.depth > 0);
+    if (--t.depth != 0) return;
+    t.sec += std::chrono::duration<double>(clock::now() - t.t0).count();
+    t.cnt++;
+  }
+
+  bool running(const std::string &name) const
+  {
+    auto it = tmrs.find(name);
+    return it != tmrs.end() && it->second.depth > 0;
+  }
+
+  double seconds(const std::string &name) const
+  {
+    auto it = tmrs.find(name);
+    return it == tmrs.end() ? 0 : it->second.sec;
+  }
+
+  long calls(const std::string &name) const
+  {
+    auto it = tmrs.find(name);
+    return it == tmrs.end() ? 0 : it->second.cnt;
+  }
+
+  std::map<std::string, double> totals() const
+  {
+    std::map<std::string, double> ret;
+    for (auto &t : tmrs) ret[t.first] = t.second.sec;
+    return ret;
+  }
+};
+
+// RAII helper, a no-op if timing is switched off (i.e. if tmrs == nullptr)
+class scoped_timer
+{
+  timers_t *tmrs;
+  const std::string name;
+
+  public:
+
+  scoped_timer(timers_t *tmrs, const std::string &name) : tmrs(tmrs), name(name)
+  {
+    if (tmrs != nullptr) tmrs->start(name);
+  }
+
+  ~scoped_timer()
+  {
+    if (tmrs != nullptr) tmrs->stop(name);
+  }
+};
+
+// timers of all threads, shared through rt_params; the report is
+// written once the last owner (i.e. after all solvers) goes away
+class timing_t
+{
+  std::mutex mtx;
+  std::map<int, timers_t> per_rank;
+
+  const std::string outdir;
+  const long n_cell;
+
+  public:
+
+  long n_sd = 0; // super-droplet count (set by the Lagrangian solver)
+
+  timing_t(const std::string &outdir, const long n_cell) : outdir(outdir), n_cell(n_cell) {}
+
+  void store(const int rank, const timers_t &tmrs)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    per_rank[rank] = tmrs;
+  }
+
+  ~timing_t()
+  {
+    if (per_rank.empty()) return;
+
+    std::ofstream os(outdir + "/timing.csv");
+    if (!os) return;
+    os << std::setprecision(6);
+
+    // all timers are inclusive, e.g. hook_post_step covers update_rhs and the output
+    os << "rank,phase,seconds,calls" << std::endl;
+    for (auto &r : per_rank)
+      for (auto &t : r.second.totals())
+        os << r.first << "," << t.first << "," << t.second << "," << r.second.calls(t.first) << std::endl;
+
+    // derived quantities based on rank 0 (which also does the output and the Lagrangian microphysics)
+    const timers_t &tmrs = per_rank.begin()->second;
+    const double wall = tmrs.seconds("step");
+    const long nt = tmrs.calls("step");
+    os << std::endl << "quantity,value" << std::endl;
+    os << "steps," << nt << std::endl;
+    os << "wall_seconds," << wall << std::endl;
+    os << "advection_seconds," << wall - tmrs.seconds("hook_ante_step") - tmrs.seconds("hook_post_step") << std::endl;
+    if (wall > 0)
+    {
+      os << "cell_steps_per_second," << double(n_cell) * nt / wall << std::endl;
+      if (n_sd > 0) os << "sd_steps_per_second," << double(n_sd) * nt / wall << std::endl;
+    }
+
+    // load imbalance: spread of the time spent waiting at icicle's barriers
+    double bmin = std::numeric_limits<double>::max(), bmax = 0;
+    for (auto &r : per_rank)
+    {
+      bmin = std::min(bmin, r.second.seconds("barrier"));
+      bmax = std::max(bmax, r.second.seconds("barrier"));
+    }
+    os << "barrier_seconds_min," << bmin << std::endl;
+    os << "barrier_seconds_max," << bmax << std::endl;
+  }
+};
@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @copyright University of Warsaw
+ * @section LICENSE
+ * GPLv3+ (see the COPYING file or http://www.gnu.org/licenses/)
+ */
+
+#pragma once
+
+#include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// a persistent thread running one task at a time (instead of launching
+// a new thread for each task); exceptions are rethrown in wait()
+class worker_t
+{
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::function<void()> task;
+  bool busy = false, done = false;
+  std::exception_ptr error;
+  std::thread thread;
+
+  void loop(const std::function<void()> &init)
+  {
+    if (init) init();
+
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+      cv.wait(lock, [&]{ return done || task; });
+      if (!task) break;
+
+      std::function<void()> tmp;
+      std::swap(tmp, task);
+
+      lock.unlock();
+      try
+      {
+        tmp();
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> guard(mtx);
+        error = std::current_exception();
+      }
+      lock.lock();
+
+      busy = false;
+      cv.notify_all();
+    }
+  }
+
+  public:
+
+  // init is run first within the worker thread (e.g. to set thread-local OpenMP settings)
+  worker_t(const std::function<void()> &init = nullptr) :
+    thread(&worker_t::loop, this, init)
+  {}
+
+  void submit(const std::function<void()> &fun)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    assert(!busy);
+    task = fun;
+    busy = true;
+    cv.notify_all();
+  }
+
+  // blocks until the last submitted task is finished (returns immediately if idle)
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [&]{ return !busy; });
+    if (!error) return;
+    std::exception_ptr tmp;
+    std::swap(tmp, error);
+    std::rethrow_exception(tmp);
+  }
+
+  ~worker_t()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      done = true;
+    }
+    cv.notify_all();
+    thread.join(); // a task being executed is completed first
+  }
+};
@@ -0,0 +1,76 @@
+// validation of the vectorised saturation adjustment (--adj=simd and
+// --adj=simd_skip) against libcloudph++'s blk_1m::adj_cellwise() for
+// a range of sub- and supersaturated states with and without condensate
+
+#include <blitz/array.h>
+
+#include "../../src/icmw8_case1.hpp"
+using real_t = icmw8_case1::real_t;
+
+#include <libcloudph++/blk_1m/adj_cellwise.hpp>
+#include "../../src/adj_simd.hpp"
+
+#include <list>
+
+#include "../common.hpp"
+
+using arr_t = blitz::Array<real_t, 1>;
+
+int main()
+{
+  // all combinations of the states below
+  std::vector<real_t> rhod, th, rv, rc, rr;
+  for (real_t rhod_ : {1.15, .95})
+    for (real_t th_ : {285, 292, 300})
+      for (int k = 0; k <= 40; ++k)
+        for (real_t rc_ : {0., 1e-5, 1e-3})
+          for (real_t rr_ : {0., 1e-4})
+          {
+            rhod.push_back(rhod_);
+            th.push_back(th_);
+            rv.push_back(4e-3 + k * 3e-4);
+            rc.push_back(rc_);
+            rr.push_back(rr_);
+          }
+  const int n = rhod.size();
+  auto arr = [n](std::vector<real_t> &v) { return arr_t(v.data(), blitz::shape(n), blitz::duplicateData); };
+
+  for (bool cevp : {true, false})
+  {
+    for (bool revp : {true, false})
+    {
+      libcloudphxx::blk_1m::opts_t<real_t> opts;
+      opts.cevp = cevp;
+      opts.revp = revp;
+
+      // reference solution
+      arr_t rhod_s = arr(rhod), th_s = arr(th), rv_s = arr(rv), rc_s = arr(rc), rr_s = arr(rr);
+      libcloudphxx::blk_1m::adj_cellwise<real_t>(opts, rhod_s, th_s, rv_s, rc_s, rr_s, real_t(1));
+
+      // both SIMD variants
+      for (bool skip : {false, true})
+      {
+        arr_t th_v = arr(th), rv_v = arr(rv), rc_v = arr(rc), rr_v = arr(rr);
+        adj_simd_t<real_t> adj;
+        adj.adj(opts, rhod.data(), th_v.data(), rv_v.data(), rc_v.data(), rr_v.data(), n, skip);
+
+        // the scalar iterations stop within r_eps from saturation
+        const real_t tol_r = 2 * opts.r_eps, tol_th = 3000 * tol_r; // dth/drv ~ L/c_p
+        const std::string what = string("cevp=") + (cevp ? "on" : "off") + " revp=" + (revp ? "on" : "off") + " skip=" + (skip ? "on" : "off");
+
+        if (blitz::max(blitz::abs(rv_v - rv_s)) > tol_r) error_macro(what << ": rv differs by " << blitz::max(blitz::abs(rv_v - rv_s)))
+        if (blitz::max(blitz::abs(rc_v - rc_s)) > tol_r) error_macro(what << ": rc differs by " << blitz::max(blitz::abs(rc_v - rc_s)))
+        if (blitz::max(blitz::abs(rr_v - rr_s)) > tol_r) error_macro(what << ": rr differs by " << blitz::max(blitz::abs(rr_v - rr_s)))
+        if (blitz::max(blitz::abs(th_v - th_s)) > tol_th) error_macro(what << ": th differs by " << blitz::max(blitz::abs(th_v - th_s)))
+        if (blitz::any(rc_v < 0 || rr_v < 0 || rv_v < 0)) error_macro(what << ": negative mixing ratios")
+
+        // total water is conserved
+        arr_t tot(n);
+        tot = arr(rv) + arr(rc) + arr(rr);
+        if (blitz::max(blitz::abs(rv_v + rc_v + rr_v - tot)) > 1e-6 * blitz::max(tot)) error_macro(what << ": total water not conserved")
+
+        notice_macro(what << ": max(abs(rv - rv_scalar)) = " << blitz::max(blitz::abs(rv_v - rv_s)))
+      }
+    }
+  }
+}
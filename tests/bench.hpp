@@ -0,0 +1,206 @@
+#pragma once
+
+// helpers for the in-process benchmarks: a solver wrapper recording
+// per-timestep wall-clock stamps, summary statistics of the samples,
+// a csv writer for them and (with ICICLE_BENCH_SOLVER defined) a driver
+// running the solvers of icicle
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
+
+using bench_clock = std::chrono::steady_clock;
+
+// stamps are taken by rank 0 after a barrier, i.e. once all threads are done with a step
+template <class solver_t>
+class timed : public solver_t
+{
+  using parent_t = solver_t;
+
+  std::vector<bench_clock::time_point> *stamps;
+  int omp_threads;
+
+  protected:
+
+  void hook_ante_loop(int nt)
+  {
+#if defined(_OPENMP)
+    // the OpenMP team used by libcloudph++ is launched from rank 0
+    if (this->rank == 0 && omp_threads > 0) omp_set_num_threads(omp_threads);
+#endif
+    parent_t::hook_ante_loop(nt);
+    this->mem->barrier();
+    if (this->rank == 0) stamps->push_back(bench_clock::now());
+  }
+
+  void hook_post_step()
+  {
+    parent_t::hook_post_step();
+    this->mem->barrier();
+    if (this->rank == 0) stamps->push_back(bench_clock::now());
+  }
+
+  public:
+
+  struct rt_params_t : parent_t::rt_params_t
+  {
+    std::vector<bench_clock::time_point> *stamps = nullptr;
+    int omp_threads = 0; // 0 -> OpenMP default
+  };
+
+  // ctor
+  timed(
+    typename parent_t::ctor_args_t args,
+    const rt_params_t &p
+  ) :
+    parent_t(args, p),
+    stamps(p.stamps),
+    omp_threads(p.omp_threads)
+  {
+    assert(stamps != nullptr);
+  }
+};
+
+// wall-clock durations [s] of the steps recorded after the first n_warm ones
+std::vector<double> step_times(
+  const std::vector<bench_clock::time_point> &stamps,
+  const int n_warm
+)
+{
+  std::vector<double> ret;
+  for (int t = n_warm + 1; t < stamps.size(); ++t)
+    ret.push_back(std::chrono::duration<double>(stamps[t] - stamps[t-1]).count());
+  return ret;
+}
+
+struct stats_t
+{
+  int n = 0;
+  double mean = 0, median = 0, p95 = 0, stddev = 0, min = 0, max = 0;
+};
+
+stats_t stats(std::vector<double> smpl)
+{
+  stats_t ret;
+  if (smpl.empty()) return ret;
+
+  std::sort(smpl.begin(), smpl.end());
+  ret.n = smpl.size();
+  ret.min = smpl.front();
+  ret.max = smpl.back();
+
+  for (auto &s : smpl) ret.mean += s;
+  ret.mean /= ret.n;
+
+  for (auto &s : smpl) ret.stddev += (s - ret.mean) * (s - ret.mean);
+  ret.stddev = ret.n > 1 ? std::sqrt(ret.stddev / (ret.n - 1)) : 0;
+
+  ret.median = ret.n % 2
+    ? smpl[ret.n / 2]
+    : (smpl[ret.n / 2 - 1] + smpl[ret.n / 2]) / 2;
+
+  // nearest-rank definition
+  ret.p95 = smpl[std::max(0, int(std::ceil(.95 * ret.n)) - 1)];
+
+  return ret;
+}
+
+// a csv file with the columns identifying a sample first, then the stats_t ones and the derived ones
+class bench_csv_t
+{
+  std::ofstream ofs;
+
+  void join(std::ostream &) {}
+
+  template <typename arg_t, typename... args_t>
+  void join(std::ostream &os, const arg_t &arg, const args_t&... args)
+  {
+    os << arg << ",";
+    join(os, args...);
+  }
+
+  public:
+
+  bench_csv_t(const std::string &file, const std::string &key_cols, const std::string &extra_cols)
+  {
+    ofs.open(file);
+    ofs << key_cols << ",n,mean,median,p95,stddev,min,max" << (extra_cols.empty() ? "" : ",") << extra_cols << std::endl;
+    ofs << std::setprecision(9);
+  }
+
+  template <typename... keys_t>
+  void row(const stats_t &st, const std::vector<double> &extra, const keys_t&... keys)
+  {
+    join(ofs, keys...);
+    ofs << st.n << "," << st.mean << "," << st.median << "," << st.p95 << "," << st.stddev << "," << st.min << "," << st.max;
+    for (auto &e : extra) ofs << "," << e;
+    ofs << std::endl;
+  }
+};
+
+#if defined(ICICLE_BENCH_SOLVER)
+// icicle's option-parsing globals (ac and av from opts_common.hpp) pointing to "bench" 
+// followed by the given options (for as long as the object lives)
+class bench_args_t
+{
+  std::vector<std::string> args;
+  std::vector<char*> argv;
+
+  public:
+
+  bench_args_t(const std::string &opts) : args({"bench"})
+  {
+    std::istringstream iss(opts);
+    std::string arg;
+    while (iss >> arg) args.push_back(arg);
+    for (auto &arg : args) argv.push_back(&arg[0]);
+    ac = argv.size();
+    av = argv.data();
+  }
+};
+
+// n_warm + n_calc timesteps of the setup with the micro-specific options given as on icicle's
+// command line (handled by the very same code as in icicle), only the initial condition being
+// written to outdir; needs the setup namespace alias, the opts_*.hpp headers and the concurr
+// template (e.g. from src/concurr.hpp) declared before this header
+template <class solver_t, template <class> class concurr_tt>
+stats_t bench_solver(
+  const std::string &opts, 
+  const int nx, const int nz, 
+  const int n_warm, const int n_calc, 
+  const std::string &outdir,
+  const int omp_threads = 0
+)
+{
+  bench_args_t args(opts);
+
+  std::vector<bench_clock::time_point> stamps;
+
+  typename timed<solver_t>::rt_params_t p;
+  p.grid_size = {nx, nz};
+  p.outdir = outdir;
+  p.outfreq = n_warm + n_calc + 1; // only the initial condition is written
+  p.spinup = 0;
+  p.stamps = &stamps;
+  p.omp_threads = omp_threads;
+  setup::setopts(p, nx, nz);
+  setopts_micro<timed<solver_t>>(p, nx, nz, n_warm + n_calc);
+
+  concurr_tt<timed<solver_t>> slv(p);
+
+  setup::intcond(slv);
+  slv.advance(n_warm + n_calc);
+
+  return stats(step_times(stamps, n_warm));
+}
+#endif
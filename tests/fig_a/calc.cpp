@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <cstdlib> // system()
+#include <fstream>
 #include <set>
 #include <string>
 #include <sstream> // std::ostringstream
+#include <thread>
 
 #include "../common.hpp"
 #include "bins.hpp"
@@ -37,7 +40,7 @@ int main(int ac, char** av)
   set<string> opts_micro({
     "--micro=blk_1m --outdir=out_blk_1m",
     "--micro=blk_2m --outdir=out_blk_2m",
-    "--micro=lgrngn --outdir=out_lgrngn --backend=CUDA --sd_conc_mean=64 --sstp_cond=10 --sstp_coal=10"  
+    "--micro=lgrngn --outdir=out_lgrngn --backend=CUDA --sd_conc_mean=64 --sstp_cond=10 --sstp_coal=10 --out_spec=compact"  
       " --out_wet=\""
         ".5e-6:25e-6|0,1,2,3;" // FSSP
         "25e-6:1|0,3;"         // "rain"
@@ -48,13 +51,19 @@ int main(int ac, char** av)
       "\""
   });
 
-  for (auto &opts_m : opts_micro)
+  // the runs are done concurrently by the sweep driver (runs already done with the same options are skipped)
   {
-    ostringstream cmd;
-    cmd << av[1] << "/src/icicle " << opts_common << " " << opts_m;  
-    notice_macro("about to call: " << cmd.str())
-
-    if (EXIT_SUCCESS != system(cmd.str().c_str()))
-      error_macro("model run failed: " << cmd.str())
+    std::ofstream jobs("jobs_a.txt");
+    for (auto &opts_m : opts_micro) jobs << opts_common << " " << opts_m << endl;
   }
+
+  // all the runs at once, the cores split evenly among them
+  const int threads = std::max(1, int(std::thread::hardware_concurrency() / opts_micro.size()));
+
+  ostringstream cmd;
+  cmd << av[1] << "/src/sweep --icicle=" << av[1] << "/src/icicle --threads=" << threads << " jobs_a.txt";
+  notice_macro("about to call: " << cmd.str())
+
+  if (EXIT_SUCCESS != system(cmd.str().c_str()))
+    error_macro("model runs failed: " << cmd.str())
 }
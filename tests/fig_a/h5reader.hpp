@@ -0,0 +1,214 @@
+#pragma once
+
+#include <blitz/array.h>
+#include <H5Cpp.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+// a reader of the output of one run (timestepNNNNNNNNNN.h5 files or series.h5,
+// see --out_layout) for post-processing: the files and datasets are kept open,
+// only the requested hyperslabs are read and the ones already read are cached;
+// fetch() reads a batch of hyperslabs file by file (single-threaded, the HDF5
+// library serialising all the calls anyway unless built thread-safe)
+class h5reader_t
+{
+  public:
+
+  // a hyperslab of a dataset at a given timestep, in the dimensions of one output step
+  // (i.e. excluding the time axis of series.h5); empty off and cnt -> the whole dataset
+  struct req_t
+  {
+    string dataset;
+    int at;
+    std::vector<hsize_t> off, cnt;
+
+    bool operator<(const req_t &o) const
+    {
+      return std::tie(dataset, at, off, cnt) < std::tie(o.dataset, o.at, o.off, o.cnt);
+    }
+  };
+
+  using data_t = std::shared_ptr<const std::vector<float>>;
+
+  private:
+
+  const string dir;
+  const bool series;
+  std::vector<float> timesteps; // of the series.h5 records
+
+  std::map<string, std::unique_ptr<H5::H5File>> files;
+  std::map<std::pair<string, string>, H5::DataSet> dsets;
+  std::map<req_t, data_t> cache;
+
+  // the file and the record (-1 if none) of a timestep
+  std::pair<string, int> where(const int at)
+  {
+    if (!series) return {dir + "/timestep" + zeropad(at, 10) + ".h5", -1};
+    const int rec = std::find(timesteps.begin(), timesteps.end(), float(at)) - timesteps.begin();
+    if (rec == int(timesteps.size())) error_macro("timestep " << at << " not in " << dir << "/series.h5")
+    return {dir + "/series.h5", rec};
+  }
+
+  H5::DataSet &dataset(const string &file, const string &name)
+  {
+    auto ds = dsets.find({file, name});
+    if (ds != dsets.end()) return ds->second;
+
+    auto &h5f = files[file];
+    if (!h5f)
+    {
+      notice_macro("about to open file: " << file)
+      h5f.reset(new H5::H5File(file, H5F_ACC_RDONLY));
+    }
+    notice_macro("about to open dataset: " << name)
+    return dsets.emplace(std::make_pair(file, name), h5f->openDataSet(name)).first->second;
+  }
+
+  // the dimensions of the dataset at a timestep, excluding the time axis
+  std::vector<hsize_t> dims(H5::DataSet &h5d, const int rec)
+  {
+    H5::DataSpace h5s = h5d.getSpace();
+    std::vector<hsize_t> n(h5s.getSimpleExtentNdims());
+    h5s.getSimpleExtentDims(n.data(), NULL);
+    if (rec >= 0) n.erase(n.begin());
+    return n;
+  }
+
+  data_t load(const req_t &req)
+  {
+    const auto wh = where(req.at);
+    int rec = wh.second;
+    H5::DataSet &h5d = dataset(wh.first, req.dataset);
+    const auto n = dims(h5d, rec);
+
+    // variables output less often than every outfreq timesteps (see --out_sched)
+    if (rec >= 0 && h5d.attrExists("timestep_freq"))
+    {
+      double freq;
+      h5d.openAttribute("timestep_freq").read(H5::PredType::NATIVE_DOUBLE, &freq);
+      if (req.at % int(freq) != 0) error_macro("timestep " << req.at << " not in the output of " << req.dataset)
+      rec = req.at / int(freq);
+    }
+
+    std::vector<hsize_t> off(req.off), cnt(req.cnt);
+    if (cnt.empty())
+    {
+      off.assign(n.size(), 0);
+      cnt = n;
+    }
+    if (off.size() != n.size() || cnt.size() != n.size())
+      error_macro("need " << n.size() << " dimensions for " << req.dataset)
+    for (std::size_t d = 0; d < n.size(); ++d)
+      if (off[d] + cnt[d] > n[d]) error_macro("hyperslab out of range of " << req.dataset)
+
+    hsize_t len = 1;
+    for (auto &c : cnt) len *= c;
+    std::shared_ptr<std::vector<float>> ret(new std::vector<float>(len));
+
+    if (rec >= 0)
+    {
+      off.insert(off.begin(), rec);
+      cnt.insert(cnt.begin(), 1);
+    }
+    H5::DataSpace h5s = h5d.getSpace();
+    h5s.selectHyperslab(H5S_SELECT_SET, cnt.data(), off.data());
+    h5d.read(ret->data(), H5::PredType::NATIVE_FLOAT, H5::DataSpace(1, &len), h5s);
+    return ret;
+  }
+
+  public:
+
+  h5reader_t(const string &dir) :
+    dir(dir),
+    series(std::ifstream(dir + "/series.h5").good())
+  {
+    if (!series) return;
+    H5::DataSet h5d = dataset(dir + "/series.h5", "timestep");
+    hsize_t n;
+    h5d.getSpace().getSimpleExtentDims(&n, NULL);
+    timesteps.resize(n);
+    h5d.read(timesteps.data(), H5::PredType::NATIVE_FLOAT);
+  }
+
+  // a hyperslab, read if not cached
+  data_t get(const req_t &req)
+  {
+    auto it = cache.find(req);
+    if (it != cache.end()) return it->second;
+    return cache.emplace(req, load(req)).first->second;
+  }
+
+  // reading (and caching) a batch of hyperslabs, timestep by timestep (i.e. file by file 
+  // with --out_layout=timestep) and dataset by dataset
+  void fetch(std::vector<req_t> reqs)
+  {
+    std::sort(reqs.begin(), reqs.end(), [](const req_t &a, const req_t &b) { 
+      return std::tie(a.at, a.dataset) < std::tie(b.at, b.dataset); 
+    });
+    for (auto &req : reqs) get(req);
+  }
+
+  // the dimensions of a dataset at a timestep (excluding the time axis of series.h5)
+  std::vector<hsize_t> shape(const string &dataset, const int at)
+  {
+    const auto wh = where(at);
+    return dims(this->dataset(wh.first, dataset), wh.second);
+  }
+
+  // a numeric attribute of a dataset
+  std::vector<double> attr(const string &dataset, const int at, const string &name)
+  {
+    H5::Attribute h5a = this->dataset(where(at).first, dataset).openAttribute(name);
+    std::vector<double> ret(h5a.getSpace().getSimpleExtentNpoints());
+    h5a.read(H5::PredType::NATIVE_DOUBLE, ret.data());
+    return ret;
+  }
+
+  // the (x, z) window [x0, x0 + nx) x [z0, z0 + nz) of a 2-D field (nx = nz = 0 -> the whole field)
+  req_t window(const string &dataset, const int at, const int x0 = 0, const int nx = 0, const int z0 = 0, const int nz = 0)
+  {
+    if (nx == 0 && nz == 0) return {dataset, at};
+    return {dataset, at, {hsize_t(x0), hsize_t(z0)}, {hsize_t(nx), hsize_t(nz)}};
+  }
+
+  // the same window of moment k for all the ranges in a compact spectral dataset (see --out_spec=compact)
+  req_t spec_window(const string &dataset, const int at, const int k, const int x0, const int nx, const int z0, const int nz)
+  {
+    const auto moms = attr(dataset, at, "moments");
+    const int im = std::find(moms.begin(), moms.end(), double(k)) - moms.begin();
+    if (im == int(moms.size())) error_macro("moment " << k << " not in " << dataset)
+    return {dataset, at, {0, hsize_t(im), hsize_t(x0), hsize_t(z0)}, {shape(dataset, at)[0], 1, hsize_t(nx), hsize_t(nz)}};
+  }
+
+  // a 2-D (x, z) field or window
+  blitz::Array<float, 2> field(const req_t &req)
+  {
+    data_t data = get(req);
+    const auto n = req.cnt.empty() ? shape(req.dataset, req.at) : req.cnt;
+    if (n.size() != 2) error_macro("need 2 dimensions")
+    blitz::Array<float, 2> ret(n[0], n[1]);
+    std::copy(data->begin(), data->end(), ret.data());
+    return ret;
+  }
+
+  // a (range, x, z) block of spec_window()
+  blitz::Array<float, 3> spec(const req_t &req)
+  {
+    data_t data = get(req);
+    if (req.cnt.size() != 4) error_macro("need 4 dimensions")
+    blitz::Array<float, 3> ret(req.cnt[0], req.cnt[2], req.cnt[3]);
+    std::copy(data->begin(), data->end(), ret.data());
+    return ret;
+  }
+
+  // releasing the file and dataset handles (and keeping the cache)
+  void close()
+  {
+    dsets.clear();
+    files.clear();
+  }
+};
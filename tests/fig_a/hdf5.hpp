@@ -2,7 +2,10 @@
 
 #include <blitz/array.h>
 #include <H5Cpp.h>
+#include <algorithm>
+#include <fstream>
 #include <map>
+#include <vector>
 
 std::map<std::string, int> h5n(
   const string &file
@@ -39,31 +42,173 @@ std::map<std::string, int> h5n(
   return map;
 }
 
+// with --out_layout=series all output steps are records of the datasets in series.h5
+// (the record index being given by the "timestep" dataset), -1 if not the case
+int h5record(
+  const string &file,
+  int at
+)
+{
+  if (!std::ifstream(file + "/series.h5").good()) return -1;
+  H5::H5File h5f(file + "/series.h5", H5F_ACC_RDONLY);
+  H5::DataSet h5d = h5f.openDataSet("timestep");
+  hsize_t n;
+  h5d.getSpace().getSimpleExtentDims(&n, NULL);
+  std::vector<float> t(n);
+  h5d.read(t.data(), H5::PredType::NATIVE_FLOAT);
+  const int rec = std::find(t.begin(), t.end(), float(at)) - t.begin();
+  if (rec == int(n)) error_macro("timestep " << at << " not in " << file << "/series.h5")
+  return rec;
+}
+
+// the file and the leading hyperslab offset (record) of a given timestep
+std::pair<string, int> h5where(
+  const string &file,
+  int at
+)
+{
+  const int rec = h5record(file, at);
+  if (rec < 0) return {file + "/timestep" + zeropad(at, 10) + ".h5", -1};
+  return {file + "/series.h5", rec};
+}
+
+// the record of a series.h5 dataset: with --out_sched, the variables output less often than every 
+// outfreq timesteps have one record per their own output interval (the timestep_freq attribute)
+int h5record(
+  H5::DataSet &h5d,
+  int at,
+  int rec
+)
+{
+  if (rec < 0 || !h5d.attrExists("timestep_freq")) return rec;
+  double freq;
+  h5d.openAttribute("timestep_freq").read(H5::PredType::NATIVE_DOUBLE, &freq);
+  if (at % int(freq) != 0) error_macro("timestep " << at << " not in the output of " << h5d.getObjName())
+  return at / int(freq);
+}
+
 auto h5load(
   const string &file, 
   const string &dataset,
   int at
 ) -> decltype(blitz::safeToReturn(blitz::Array<float, 2>() + 0))
  {
-  notice_macro("about to open file: " << file)
-  H5::H5File h5f(file + "/timestep" + zeropad(at, 10) + ".h5", H5F_ACC_RDONLY);
+  const auto where = h5where(file, at);
+  const int d = where.second < 0 ? 0 : 1; // d: the time axis, if any
+
+  notice_macro("about to open file: " << where.first)
+  H5::H5File h5f(where.first, H5F_ACC_RDONLY);
 
   notice_macro("about to read dataset: " << dataset)
   H5::DataSet h5d = h5f.openDataSet(dataset);
   H5::DataSpace h5s = h5d.getSpace();
+  const int rec = h5record(h5d, at, where.second);
 
-  if (h5s.getSimpleExtentNdims() != 2) 
+  if (h5s.getSimpleExtentNdims() != 2 + d) 
     error_macro("need 2 dimensions")
 
-  hsize_t n[2];
+  hsize_t n[3];
   enum {x, z};
   h5s.getSimpleExtentDims(n, NULL);
 
+  blitz::Array<float, 2> tmp(n[d + x], n[d + z]);
+
+  hsize_t 
+    cnt[3] = { 1,           n[d + x], n[d + z] }, 
+    off[3] = { hsize_t(rec), 0,       0        };
+  h5s.selectHyperslab( H5S_SELECT_SET, cnt + 1 - d, off + 1 - d);
+
+  hsize_t ext[2] = {
+    hsize_t(tmp.extent(0)), 
+    hsize_t(tmp.extent(1))
+  };
+  h5d.read(tmp.data(), H5::PredType::NATIVE_FLOAT, H5::DataSpace(2, ext), h5s);
+
+  return blitz::safeToReturn(tmp + 0);
+}
+
+// a (x, z) slice of a compact spectral dataset (see --out_spec=compact):
+// the one for range number rng (as numbered in --out_dry/--out_wet) and moment k
+auto h5load_spec(
+  const string &file, 
+  const string &dataset,
+  int at,
+  int rng,
+  int k
+) -> decltype(blitz::safeToReturn(blitz::Array<float, 2>() + 0))
+{
+  const auto where = h5where(file, at);
+  const int d = where.second < 0 ? 0 : 1; // d: the time axis, if any
+
+  notice_macro("about to open file: " << where.first)
+  H5::H5File h5f(where.first, H5F_ACC_RDONLY);
+
+  notice_macro("about to read dataset: " << dataset)
+  H5::DataSet h5d = h5f.openDataSet(dataset);
+  H5::DataSpace h5s = h5d.getSpace();
+  const int rec = h5record(h5d, at, where.second);
+
+  if (h5s.getSimpleExtentNdims() != 4 + d) 
+    error_macro("need 4 dimensions")
+
+  hsize_t dims[5], *n = dims + d;
+  enum {r, m, x, z};
+  h5s.getSimpleExtentDims(dims, NULL);
+
+  // locating the range and the moment using the attributes
+  std::vector<double> rng_first(1), moms(n[m]);
+  h5d.openAttribute("rng_first").read(H5::PredType::NATIVE_DOUBLE, rng_first.data());
+  h5d.openAttribute("moments").read(H5::PredType::NATIVE_DOUBLE, moms.data());
+
+  const int ir = rng - int(rng_first[0]);
+  if (ir < 0 || ir >= int(n[r])) error_macro("range " << rng << " not in " << dataset)
+  const int im = std::find(moms.begin(), moms.end(), double(k)) - moms.begin();
+  if (im == int(n[m])) error_macro("moment " << k << " not in " << dataset)
+
   blitz::Array<float, 2> tmp(n[x], n[z]);
 
   hsize_t 
-    cnt[2] = { n[x], n[z] }, 
-    off[2] = { 0,    0    };
+    cnt[5] = { 1,            1,           1,           n[x], n[z] }, 
+    off[5] = { hsize_t(rec), hsize_t(ir), hsize_t(im), 0,    0    };
+  h5s.selectHyperslab( H5S_SELECT_SET, cnt + 1 - d, off + 1 - d);
+
+  hsize_t ext[2] = {
+    hsize_t(tmp.extent(0)), 
+    hsize_t(tmp.extent(1))
+  };
+  h5d.read(tmp.data(), H5::PredType::NATIVE_FLOAT, H5::DataSpace(2, ext), h5s);
+
+  return blitz::safeToReturn(tmp + 0);
+}
+
+// a (t, z) time series of the column at x (all records, see --out_layout=series), 
+// read in one go; records never written are NaN
+auto h5load_column(
+  const string &file, 
+  const string &dataset,
+  int x
+) -> decltype(blitz::safeToReturn(blitz::Array<float, 2>() + 0))
+{
+  notice_macro("about to open file: " << file << "/series.h5")
+  H5::H5File h5f(file + "/series.h5", H5F_ACC_RDONLY);
+
+  notice_macro("about to read dataset: " << dataset)
+  H5::DataSet h5d = h5f.openDataSet(dataset);
+  H5::DataSpace h5s = h5d.getSpace();
+
+  if (h5s.getSimpleExtentNdims() != 3) 
+    error_macro("need 3 dimensions")
+
+  hsize_t n[3];
+  enum {t, xx, z};
+  h5s.getSimpleExtentDims(n, NULL);
+  if (x < 0 || x >= int(n[xx])) error_macro("column " << x << " not in " << dataset)
+
+  blitz::Array<float, 2> tmp(n[t], n[z]);
+
+  hsize_t 
+    cnt[3] = { n[t], 1,          n[z] }, 
+    off[3] = { 0,    hsize_t(x), 0    };
   h5s.selectHyperslab( H5S_SELECT_SET, cnt, off);
 
   hsize_t ext[2] = {
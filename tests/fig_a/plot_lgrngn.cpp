@@ -13,6 +13,9 @@ int main(int ac, char** av)
 
   auto n = h5n(h5);
 
+  // the spectra are output with --out_spec=compact (see calc.cpp): ranges 0 (moments 0-3),
+  // 1 (moments 0 and 3) and 2 onwards (moment 0) in rw_spec_rng000, 001 and 002, respectively
+
   for (int at = 0; at < n["t"]; ++at) // TODO: mark what time does it actually mean!
   {
     for (auto &plt : std::set<std::string>({"rl", "rr", "nc", "nr", "ef", "na"}))
@@ -72,7 +75,7 @@ int main(int ac, char** av)
       {
 	// cloud water content
 	//                                                         rho_w  kg2g
-	auto tmp = h5load(h5, "rw_rng000_mom3", at * n["outfreq"]) * 4./3 * 3.14 * 1e3 * 1e3;
+	auto tmp = h5load_spec(h5, "rw_spec_rng000", at * n["outfreq"], 0, 3) * 4./3 * 3.14 * 1e3 * 1e3;
 	gp << "set title 'cloud water mixing ratio [g/kg]'\n";
 	gp << "set cbrange [0:1.5]\n";
 	plot(gp, tmp);
@@ -81,7 +84,7 @@ int main(int ac, char** av)
       {
 	// rain water content
 	//                                                         rho_w  kg2g
-	auto tmp = h5load(h5, "rw_rng001_mom3", at * n["outfreq"]) * 4./3 * 3.14 * 1e3 * 1e3;
+	auto tmp = h5load_spec(h5, "rw_spec_rng001", at * n["outfreq"], 1, 3) * 4./3 * 3.14 * 1e3 * 1e3;
 	gp << "set logscale cb\n";
 	gp << "set title 'rain water mixing ratio [g/kg]'\n";
 	gp << "set cbrange [1e-2:1]\n";
@@ -91,7 +94,7 @@ int main(int ac, char** av)
       else if (plt == "nc")
       {
 	// cloud particle concentration
-	auto tmp = 1e-6 * h5load(h5, "rw_rng000_mom0", at * n["outfreq"]);
+	auto tmp = 1e-6 * h5load_spec(h5, "rw_spec_rng000", at * n["outfreq"], 0, 0);
 	gp << "set title 'cloud droplet spec. conc. [mg^{-1}]'\n";
 	gp << "set cbrange [0:150]\n";
 	plot(gp, tmp);
@@ -99,7 +102,7 @@ int main(int ac, char** av)
       else if (plt == "nr")
       {
 	// rain particle concentration
-	auto tmp = 1e-6 * h5load(h5, "rw_rng001_mom0", at * n["outfreq"]);
+	auto tmp = 1e-6 * h5load_spec(h5, "rw_spec_rng001", at * n["outfreq"], 1, 0);
 	gp << "set title 'rain drop spec. conc. [mg^{-1}]'\n";
 	gp << "set cbrange [.01:10]\n";
 	gp << "set logscale cb\n";
@@ -109,7 +112,7 @@ int main(int ac, char** av)
       else if (plt == "ef")
       {
 	// effective radius
-	auto r_eff = h5load(h5, "rw_rng000_mom3", at * n["outfreq"]) / h5load(h5, "rw_rng000_mom2", at * n["outfreq"]) * 1e6;
+	auto r_eff = h5load_spec(h5, "rw_spec_rng000", at * n["outfreq"], 0, 3) / h5load_spec(h5, "rw_spec_rng000", at * n["outfreq"], 0, 2) * 1e6;
 	gp << "set title 'cloud droplet effective radius [μm]'\n"; 
 	gp << "set cbrange [1:20]\n";
 	plot(gp, r_eff);
@@ -117,14 +120,12 @@ int main(int ac, char** av)
       else if (plt == "na")
       {
 	// aerosol concentration
-	blitz::Array<float, 2> tmp(h5load(h5, "rw_rng002_mom0", at * n["outfreq"]));
+	blitz::Array<float, 2> tmp(h5load_spec(h5, "rw_spec_rng002", at * n["outfreq"], 2, 0));
 	vector<quantity<si::length>> left_edges = bins_wet();
 	for (int i = 1; i < left_edges.size()-1; ++i)
 	{
 	  if (left_edges[i + 1] > 1e-6 * si::metres) break;
-	  ostringstream str;
-	  str << "rw_rng" << std::setw(3) << std::setfill('0') << i + 2  << "_mom0";
-	  tmp = tmp + h5load(h5, str.str(), at * n["outfreq"]);
+	  tmp = tmp + h5load_spec(h5, "rw_spec_rng002", at * n["outfreq"], i + 2, 0);
 	}
 	gp << "set cbrange [" << 0 << ":" << 150 << "]\n";
 	gp << "set title 'aerosol concentration [mg^{-1}]'\n";
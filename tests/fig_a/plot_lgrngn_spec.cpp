@@ -1,7 +1,7 @@
 #include "../common.hpp"
 #include "bins.hpp"
 #include "gnuplot.hpp"
-#include "hdf5.hpp"
+#include "h5reader.hpp"
 
 #include <map>
 
@@ -39,6 +39,19 @@ int main(int ac, char** av)
 
 // TODO: use dashed lines to allow printing in black and white... same in image plots
 
+  // the 3x3 windows around the focus gridboxes, for all bins at once
+  h5reader_t rdr(h5);
+  const string ds_d = "rd_spec_rng000", ds_w = "rw_spec_rng" + zeropad(off);
+  std::vector<h5reader_t::req_t> reqs;
+  for (auto &fcs : {focus.first, focus.second})
+    for (auto &xy : fcs)
+      for (auto &ds : {ds_d, ds_w})
+        reqs.push_back(rdr.spec_window(ds, at, 0, xy.first - 1, 3, xy.second - 1, 3));
+  rdr.fetch(reqs);
+  const int 
+    first_d = rdr.attr(ds_d, at, "rng_first")[0], 
+    first_w = rdr.attr(ds_w, at, "rng_first")[0];
+
   assert(focus.first.size() == focus.second.size());
   gp << "set multiplot layout " << focus.first.size() << ",2 columnsfirst upwards\n";
 
@@ -62,14 +75,16 @@ int main(int ac, char** av)
       vector<quantity<si::length>> left_edges_rw = bins_wet();
       int nsw = left_edges_rw.size() - 1;
 
+      blitz::Array<float, 3> 
+        spec_d(rdr.spec(rdr.spec_window(ds_d, at, 0, x-1, 3, y-1, 3))), 
+        spec_w(rdr.spec(rdr.spec_window(ds_w, at, 0, x-1, 3, y-1, 3)));
+
       for (int i = 0; i < nsd; ++i)
       {
-	const string name = "rd_rng" + zeropad(i) + "_mom0";
-	blitz::Array<float, 2> tmp_d(1e-6 * h5load(h5, name, at));
-
-	focus_d[left_edges_rd[i] / 1e-6 / si::metres] = sum(tmp_d(
-	  blitz::Range(x-1, x+1),
-	  blitz::Range(y-1, y+1)
+	focus_d[left_edges_rd[i] / 1e-6 / si::metres] = 1e-6 * sum(spec_d(
+	  i - first_d,
+	  blitz::Range::all(),
+	  blitz::Range::all()
 	)) 
 	/ 9  // mean over 9 gridpoints
 	/ ((left_edges_rd[i+1] - left_edges_rd[i]) / 1e-6 / si::metres); // per micrometre
@@ -77,12 +92,10 @@ int main(int ac, char** av)
 
       for (int i = 0; i < nsw; ++i)
       {
-	const string name = "rw_rng" + zeropad(i + off) + "_mom0";
-	blitz::Array<float, 2> tmp_w(1e-6 * h5load(h5, name, at));
-
-	focus_w[left_edges_rw[i] / 1e-6 / si::metres] = sum(tmp_w(
-	  blitz::Range(x-1, x+1),
-	  blitz::Range(y-1, y+1)
+	focus_w[left_edges_rw[i] / 1e-6 / si::metres] = 1e-6 * sum(spec_w(
+	  i + off - first_w,
+	  blitz::Range::all(),
+	  blitz::Range::all()
 	)) 
 	/ 9 
 	/ ((left_edges_rw[i+1] - left_edges_rw[i]) / 1e-6 / si::metres); // per micrometre
@@ -0,0 +1,156 @@
+// in-process counterpart of calc.cpp: the solvers are linked directly,
+// per-step wall times are recorded from within the timestepping loop
+// and summarised after discarding the warm-up steps; results go to
+// bench.csv and bench.json in the current directory
+
+#include "../../src/concurr.hpp"
+
+#include "../../src/icmw8_case1.hpp"
+namespace setup = icmw8_case1;
+
+#include "../../src/opts_blk_1m.hpp"
+#include "../../src/opts_blk_2m.hpp"
+#include "../../src/opts_lgrngn.hpp"
+#include "../../src/ct_params.hpp"
+
+#include <fstream>
+#include <list>
+#include <map>
+#include <memory>
+
+#include "../common.hpp"
+#define ICICLE_BENCH_SOLVER
+#include "../bench.hpp"
+
+using std::list;
+using std::map;
+using std::pair;
+
+// whether the lgrngn backend can be used here (libcloudph++'s factory throwing 
+// if it was not compiled in, or e.g. if there is no CUDA device)
+bool usable(const string &backend, const int nx, const int nz)
+{
+  using solver_t = kin_cloud_2d_lgrngn<ct_params_lgrngn<>>;
+  using real_t = solver_t::real_t;
+
+  bench_args_t args("--backend=" + backend);
+  solver_t::rt_params_t p;
+  p.grid_size = {nx, nz};
+  setup::setopts(p, nx, nz);
+  setopts_micro<solver_t>(p, nx, nz, 1);
+
+  // as in kin_cloud_2d_lgrngn::hook_ante_loop()
+  p.cloudph_opts_init.dt = p.dt;
+  p.cloudph_opts_init.dx = p.dx;
+  p.cloudph_opts_init.dz = p.dz;
+  p.cloudph_opts_init.x0 = p.dx / 2;
+  p.cloudph_opts_init.z0 = p.dz / 2;
+  p.cloudph_opts_init.x1 = (nx - .5) * p.dx;
+  p.cloudph_opts_init.z1 = (nz - .5) * p.dz;
+
+  try
+  {
+    std::unique_ptr<libcloudphxx::lgrngn::particles_proto_t<real_t>>(libcloudphxx::lgrngn::factory<real_t>(
+      (libcloudphxx::lgrngn::backend_t)p.backend, p.cloudph_opts_init
+    ));
+  }
+  catch (std::exception &e)
+  {
+    notice_macro("skipping --backend=" << backend << ": " << e.what())
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) // note: ac and av are the option-parsing globals from opts_common.hpp
+{
+  const int nx = 76, nz = 76, n_warm = 5;
+
+  // optional arguments: the list of lgrngn backends to cover (by default the usable ones of the three)
+  list<string> backends;
+  if (argc > 1) backends = list<string>(argv + 1, argv + argc);
+  else for (auto &b : list<string>({"CUDA", "OpenMP", "serial"})) if (usable(b, nx, nz)) backends.push_back(b);
+
+  using str = std::string;
+  using mss = std::map<str,str>;
+
+  // the same process toggles as in calc.cpp
+  map<str,mss> proc({
+    pair<str,mss>({"blk_1m", mss({
+      pair<str,str>({"a___","--cond=off --cevp=off --revp=off --conv=off --accr=off --sedi=off"}),
+      pair<str,str>({"ac__","--cond=on  --cevp=on  --revp=on  --conv=off --accr=off --sedi=off"}),
+      pair<str,str>({"acc_","--cond=on  --cevp=on  --revp=on  --conv=on  --accr=on  --sedi=off"}),
+      pair<str,str>({"accs","--cond=on  --cevp=on  --revp=on  --conv=on  --accr=on  --sedi=on "})
+    })}),
+    pair<str,mss>({"blk_2m", mss({
+      pair<str,str>({"a___","--acti=off --cond=off --accr=off --acnv=off --sedi=off"}),
+      pair<str,str>({"ac__","--acti=on  --cond=on  --accr=off --acnv=off --sedi=off"}),
+      pair<str,str>({"acc_","--acti=on  --cond=on  --accr=on  --acnv=on  --sedi=off"}),
+      pair<str,str>({"accs","--acti=on  --cond=on  --accr=on  --acnv=on  --sedi=on "})
+    })}),
+    pair<str,mss>({"lgrngn", mss({
+      pair<str,str>({"a___","--adve=on --cond=off --coal=off --sedi=off"}),
+      pair<str,str>({"ac__","--adve=on --cond=on  --coal=off --sedi=off"}),
+      pair<str,str>({"acc_","--adve=on --cond=on  --coal=on  --sedi=off"}),
+      pair<str,str>({"accs","--adve=on --cond=on  --coal=on  --sedi=on "}),
+    })})
+  });
+
+  bench_csv_t csv("bench.csv", "micro,backend,omp_threads,sd_conc_mean,processes", "steps_per_s");
+  std::ofstream json("bench.json");
+  json << "[" << std::setprecision(9);
+  bool first = true;
+
+  for (auto &micro : list<string>({"blk_1m", "blk_2m", "lgrngn"}))
+  {
+    for (auto &backend : micro == "lgrngn" ? backends : list<string>({""}))
+    {
+      for (auto &omp_threads : micro == "lgrngn" && backend == "OpenMP"
+        ? list<int>({2, 4})
+        : list<int>({0})
+      ) {
+        for (auto &sd_conc : micro == "lgrngn"
+          ? list<int>({8, 32, 128})
+          : list<int>({0})
+        ) {
+          for (auto prcs : list<string>({"a___","ac__","acc_","accs"}))
+          {
+            ostringstream opts;
+            opts << proc.at(micro).at(prcs);
+            if (micro == "lgrngn") opts
+              << " --backend=" << backend
+              << " --sd_conc_mean=" << sd_conc
+              << " --sstp_cond=10 --sstp_coal=10";
+
+            // bulk schemes are cheap enough to afford a larger sample
+            const int n_calc = micro != "lgrngn" ? 100 : 20;
+
+            notice_macro("about to benchmark: --micro=" << micro << " " << opts.str())
+
+            stats_t st;
+            if (micro == "blk_1m")
+              st = bench_solver<kin_cloud_2d_blk_1m<ct_params_blk_1m<>>, concurr_boost_thread>(opts.str(), nx, nz, n_warm, n_calc, "bench_out", omp_threads);
+            else if (micro == "blk_2m")
+              st = bench_solver<kin_cloud_2d_blk_2m<ct_params_blk_2m<>>, concurr_boost_thread>(opts.str(), nx, nz, n_warm, n_calc, "bench_out", omp_threads);
+            else
+              st = bench_solver<kin_cloud_2d_lgrngn<ct_params_lgrngn<>>, concurr_boost_thread>(opts.str(), nx, nz, n_warm, n_calc, "bench_out", omp_threads);
+
+            csv.row(st, {1 / st.median}, micro, backend, omp_threads, sd_conc, prcs);
+
+            json
+              << (first ? "" : ",") << endl
+              << "  {\"micro\": \"" << micro << "\", \"backend\": \"" << backend << "\", "
+              << "\"omp_threads\": " << omp_threads << ", \"sd_conc_mean\": " << sd_conc << ", "
+              << "\"processes\": \"" << prcs << "\", \"n\": " << st.n << ", "
+              << "\"mean\": " << st.mean << ", \"median\": " << st.median << ", "
+              << "\"p95\": " << st.p95 << ", \"stddev\": " << st.stddev << ", "
+              << "\"min\": " << st.min << ", \"max\": " << st.max << ", "
+              << "\"steps_per_s\": " << 1 / st.median << "}";
+            first = false;
+          }
+        }
+      }
+    }
+  }
+  json << endl << "]" << endl;
+}
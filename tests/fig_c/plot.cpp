@@ -31,18 +31,18 @@ int main(int ac, char** av)
   for (const auto &i : tmp) v[1].push_back(i);
 
   tmp = - A * ( 
-    psi((ix+.5)/n["x"], (jx+.5+.5)/n["z"])-
-    psi((ix+.5)/n["x"], (jx+.5-.5)/n["z"])
+    psi<float>()((ix+.5)/n["x"], (jx+.5+.5)/n["z"])-
+    psi<float>()((ix+.5)/n["x"], (jx+.5-.5)/n["z"])
   ) / dz                  // numerical derivative
-  / rhod()((jx+.5) * dz); // psi defines rho_d times velocity
+  / rhod<float>()((jx+.5) * dz); // psi defines rho_d times velocity
 
   for (const auto &i : tmp) v[2].push_back(i);
 
   tmp = A * ( 
-    psi((ix+.5+.5)/n["x"], (jx+.5)/n["z"]) -
-    psi((ix+.5-.5)/n["x"], (jx+.5)/n["z"])
+    psi<float>()((ix+.5+.5)/n["x"], (jx+.5)/n["z"]) -
+    psi<float>()((ix+.5-.5)/n["x"], (jx+.5)/n["z"])
   ) / dx  
-  / rhod()(jx * dz);
+  / rhod<float>()(jx * dz);
 
   for (const auto &i : tmp) v[3].push_back(i);
 
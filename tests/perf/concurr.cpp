@@ -0,0 +1,83 @@
+// solver benchmark: the concurrency backends of libmpdata++ selectable with
+// --concurr (see src/concurr.hpp) compared across the grid sizes, with the
+// bulk scheme (the cheapest microphysics, i.e. the case in which the
+// synchronisation overhead matters most) and all processes on; for the
+// threaded backends the thread counts are powers of two up to the core
+// count (at most nx/2, as the domain is split along x); per-step wall times
+// are recorded from within the timestepping loop (see bench.hpp); results
+// go to concurr.csv in the current directory
+
+#include "../../src/concurr.hpp"
+
+#include "../../src/icmw8_case1.hpp"
+namespace setup = icmw8_case1;
+
+#include "../../src/opts_blk_1m.hpp"
+#include "../../src/ct_params.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <list>
+#include <thread>
+
+#include "../common.hpp"
+#define ICICLE_BENCH_SOLVER
+#include "../bench.hpp"
+
+using std::list;
+
+// libmpdata++'s thread count is taken from OMP_NUM_THREADS (and, for
+// the openmp backend, from the OpenMP runtime already initialised)
+void set_threads(const int n)
+{
+  setenv("OMP_NUM_THREADS", std::to_string(n).c_str(), 1);
+#if defined(_OPENMP)
+  omp_set_num_threads(n);
+#endif
+}
+
+int main()
+{
+  using solver_t = kin_cloud_2d_blk_1m<ct_params_blk_1m<>>;
+
+  const int n_warm = 5, n_cpu = std::max(1u, std::thread::hardware_concurrency());
+
+  bench_csv_t csv("concurr.csv", "concurr,nx,nz,threads", "steps_per_s,cells_per_s");
+
+  // from below the default grid up to the finer ones
+  for (auto &n : list<int>({32, 76, 152, 304}))
+  {
+    const int nx = n, nz = n;
+
+    // a sample of roughly the same cost for all the sizes
+    const int n_calc = std::max(10, int(100 * (76. * 76) / (nx * nz)));
+
+    for (auto &concurr : concurr_names())
+    {
+      list<int> threads({1});
+      if (concurr != "serial")
+        for (int t = 2; t <= std::min(n_cpu, nx / 2); t *= 2) threads.push_back(t);
+
+      for (auto &t : threads)
+      {
+        notice_macro("about to benchmark: --concurr=" << concurr << " --nx=" << nx << " --nz=" << nz << " with " << t << " thread(s)")
+        set_threads(t);
+
+        stats_t st;
+        if (concurr == "boost_thread")
+          st = bench_solver<solver_t, concurr_boost_thread>("", nx, nz, n_warm, n_calc, "concurr_out");
+        else if (concurr == "openmp")
+          st = bench_solver<solver_t, concurr_openmp>("", nx, nz, n_warm, n_calc, "concurr_out");
+        else if (concurr == "serial")
+          st = bench_solver<solver_t, concurr_serial>("", nx, nz, n_warm, n_calc, "concurr_out");
+#if defined(ICICLE_CXX11_THREAD)
+        else if (concurr == "cxx11_thread")
+          st = bench_solver<solver_t, concurr_cxx11_thread>("", nx, nz, n_warm, n_calc, "concurr_out");
+#endif
+        else error_macro("unknown backend: " << concurr)
+
+        csv.row(st, {1 / st.median, nx * nz / st.median}, concurr, nx, nz, t);
+      }
+    }
+  }
+}
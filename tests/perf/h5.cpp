@@ -0,0 +1,136 @@
+// output benchmark: write time vs. file size for the storage filters
+// of h5_writer.hpp (chunking, shuffle+deflate, mantissa rounding) applied
+// to synthetic fields resembling a timestep of a bulk-microphysics run
+// (smooth th and rv, cloud and rain water zero over most of the domain);
+// each sample is a complete output step (file created, fields written,
+// file closed); the rounding error is checked against its bound; results
+// go to h5.csv in the current directory; with --check only the latter is
+// done, on the smallest grid (as a test)
+
+#include "../../src/h5_writer.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <memory>
+
+#include "../common.hpp"
+#include "../bench.hpp"
+
+// th, rv, rc, rr on an nx x nz grid
+std::vector<h5_field_t> fields(const int nx, const int nz)
+{
+  std::vector<h5_field_t> ret(4);
+  const char *names[] = {"th", "rv", "rc", "rr"};
+  for (int f = 0; f < 4; ++f)
+  {
+    ret[f].name = names[f];
+    ret[f].shape = {hsize_t(nx), hsize_t(nz)};
+    ret[f].data.resize(nx * nz);
+  }
+
+  for (int i = 0; i < nx; ++i)
+    for (int j = 0; j < nz; ++j)
+    {
+      const float x = float(i) / nx, z = float(j) / nz;
+      const int c = i * nz + j;
+      ret[0].data[c] = 289 + 10 * z + .1 * std::sin(40 * x) * std::cos(30 * z);
+      ret[1].data[c] = 7.5e-3 - 1e-3 * z + 1e-5 * std::cos(25 * x + 15 * z);
+      ret[2].data[c] = z > .4 && z < .7 && std::sin(6.28 * x) > .3 ? 5e-4 * std::sin(6.28 * x) * (z - .4) : 0;
+      ret[3].data[c] = std::sin(6.28 * x) > .8 ? 1e-5 * (1 + std::cos(50 * z)) : 0;
+    }
+  return ret;
+}
+
+long file_size(const std::string &file)
+{
+  std::ifstream ifs(file, std::ios::binary | std::ios::ate);
+  return ifs.tellg();
+}
+
+// max. relative difference between the written and the read-back field
+double max_rel_err(const std::string &file, const h5_field_t &fld)
+{
+  H5::H5File h5f(file, H5F_ACC_RDONLY);
+  std::vector<float> tmp(fld.data.size());
+  h5f.openDataSet(fld.name).read(tmp.data(), H5::PredType::NATIVE_FLOAT);
+  double ret = 0;
+  for (std::size_t c = 0; c < tmp.size(); ++c)
+    if (fld.data[c] != 0) ret = std::max(ret, std::abs(double(tmp[c]) / fld.data[c] - 1));
+    else if (tmp[c] != 0) ret = HUGE_VAL;
+  return ret;
+}
+
+int main(int argc, char** argv)
+{
+  const bool check_only = argc > 1 && std::string(argv[1]) == "--check";
+
+  const int n_warm = check_only ? 0 : 1, n_calc = check_only ? 1 : 5;
+  const std::string file = "perf_h5.h5";
+
+  struct config_t { std::string name; h5_filters_t filters; };
+  std::list<config_t> configs;
+  configs.push_back({"contiguous", {}});
+  configs.push_back({"chunk64", {}});
+  configs.back().filters.chunk = {64, 64};
+  for (int level : {1, 4})
+  {
+    configs.push_back({"deflate" + std::to_string(level), {}});
+    configs.back().filters.deflate = level;
+  }
+  for (int bits : {16, 10, 7})
+  {
+    configs.push_back({"deflate1_keepbits" + std::to_string(bits), {}});
+    configs.back().filters.deflate = 1;
+    configs.back().filters.keepbits[""] = bits;
+  }
+
+  std::unique_ptr<bench_csv_t> csv;
+  if (!check_only) csv.reset(new bench_csv_t("h5.csv", "nx,nz,config", "bytes,ratio,raw_MB_per_s"));
+
+  // from the fig_a grid to production-size ones
+  using grids_t = std::list<std::pair<int,int>>;
+  for (auto &nxnz : check_only ? grids_t({{76, 76}}) : grids_t({{76, 76}, {512, 512}, {2048, 2048}}))
+  {
+    const int nx = nxnz.first, nz = nxnz.second;
+    std::vector<h5_field_t> flds = fields(nx, nz);
+    const double raw = 4. * flds.size() * nx * nz;
+
+    for (auto &cfg : configs)
+    {
+      vector<double> smpl;
+      for (int t = 0; t < n_warm + n_calc; ++t)
+      {
+        const auto t0 = bench_clock::now();
+        {
+          h5_writer_t writer(cfg.filters);
+          for (auto &fld : flds)
+          {
+            fld.file = file;
+            fld.create = &fld == &flds.front();
+            writer.write(fld);
+          }
+          writer.close();
+        }
+        if (t >= n_warm) smpl.push_back(std::chrono::duration<double>(bench_clock::now() - t0).count());
+      }
+      const stats_t st = stats(smpl);
+      const long bytes = file_size(file);
+
+      // rounding to nearest: half a unit in the last kept place
+      for (auto &fld : flds)
+      {
+        const auto kb = cfg.filters.keepbits.find("");
+        const double bound = kb == cfg.filters.keepbits.end() ? 0 : std::ldexp(1., -kb->second - 1);
+        const double err = max_rel_err(file, fld);
+        if (err > bound) error_macro(cfg.name << ": relative error of " << fld.name << " (" << err << ") above " << bound)
+      }
+
+      if (!csv) continue;
+      csv->row(st, {double(bytes), raw / bytes, raw / st.median / 1e6}, nx, nz, cfg.name);
+      notice_macro(nx << "x" << nz << " " << cfg.name << ": " << st.median << " s (median), " << bytes << " bytes (" << raw / bytes << "x)")
+    }
+  }
+  std::remove(file.c_str());
+}
@@ -0,0 +1,250 @@
+// kernel-level benchmark of the bulk-microphysics rhs: the former two
+// sweeps over the whole subdomain (cell-wise, then column-wise) vs. the
+// fused column-by-column sweep from rhs_fused.hpp, the latter with the
+// process toggles checked at run time and given as template parameters;
+// all are applied to the same fields and checked to give identical
+// tendencies; results go to rhs.csv in the current directory; with
+// --check only the latter is done, on the smallest grid (as a test)
+
+#include <blitz/array.h>
+
+#include "../../src/icmw8_case1.hpp"
+namespace setup = icmw8_case1;
+using real_t = setup::real_t;
+
+#include "../../src/rhs_fused.hpp"
+
+#include <fstream>
+#include <functional>
+#include <list>
+#include <memory>
+
+#include "../common.hpp"
+#include "../bench.hpp"
+
+using arr_t = blitz::Array<real_t, 2>;
+using blitz::Range;
+
+// cloud in the lower half and rain everywhere, so that all terms are non-trivial
+struct fields_t
+{
+  arr_t rhod, th, rv, rc, nc, rr, nr;
+
+  fields_t(int nx, int nz) :
+    rhod(nx, nz), th(nx, nz), rv(nx, nz), rc(nx, nz), nc(nx, nz), rr(nx, nz), nr(nx, nz)
+  {
+    blitz::firstIndex i;
+    blitz::secondIndex j;
+    rhod = 1.1 - .2 * j / nz;
+    th   = 289 + 10. * j / nz;
+    rv   = 7.5e-3 - 1e-3 * j / nz;
+    rc   = blitz::where(j < nz / 2, 5e-4 * (1 + .1 * blitz::sin(i * .1)), 0.);
+    nc   = blitz::where(j < nz / 2, 5e7, 0.);
+    rr   = 1e-5 * (1 + blitz::cos(i * .05 + j * .03));
+    nr   = 1e4  * (1 + blitz::cos(i * .05 + j * .03));
+  }
+};
+
+// the code formerly used in kin_cloud_2d_blk_1m::update_rhs()
+void two_pass_blk_1m(
+  const libcloudphxx::blk_1m::opts_t<real_t> &opts,
+  arr_t &dot_rc, arr_t &dot_rr,
+  const fields_t &f,
+  const Range &i, const Range &j,
+  const real_t &dz
+)
+{
+  {
+    auto
+      dot_rc_v = dot_rc(i, j),
+      dot_rr_v = dot_rr(i, j);
+    const auto
+      rc = f.rc(i, j),
+      rr = f.rr(i, j);
+    libcloudphxx::blk_1m::rhs_cellwise<real_t>(opts, dot_rc_v, dot_rr_v, rc, rr);
+  }
+
+  for (int ii = i.first(); ii <= i.last(); ++ii)
+  {
+    auto
+      dot_rr_c = dot_rr(ii, j);
+    const auto
+      rhod = f.rhod(ii, j),
+      rr   = f.rr(ii, j);
+    libcloudphxx::blk_1m::rhs_columnwise<real_t>(opts, dot_rr_c, rhod, rr, dz);
+  }
+}
+
+// the code formerly used in kin_cloud_2d_blk_2m::update_rhs() (sans the barriers)
+void two_pass_blk_2m(
+  const libcloudphxx::blk_2m::opts_t<real_t> &opts,
+  std::vector<arr_t> &dot,
+  const fields_t &f,
+  const Range &i, const Range &j,
+  const real_t &dt, const real_t &dz
+)
+{
+  {
+    auto
+      dot_th = dot[0](i, j),
+      dot_rv = dot[1](i, j),
+      dot_rc = dot[2](i, j),
+      dot_nc = dot[3](i, j),
+      dot_rr = dot[4](i, j),
+      dot_nr = dot[5](i, j);
+    const auto
+      rhod = f.rhod(i, j),
+      th   = f.th(i, j),
+      rv   = f.rv(i, j),
+      rc   = f.rc(i, j),
+      nc   = f.nc(i, j),
+      rr   = f.rr(i, j),
+      nr   = f.nr(i, j);
+    libcloudphxx::blk_2m::rhs_cellwise<real_t>(
+      opts, dot_th, dot_rv, dot_rc, dot_nc, dot_rr, dot_nr,
+      rhod,   th,     rv,     rc,     nc,     rr,     nr,
+      dt
+    );
+  }
+
+  for (int ii = i.first(); ii <= i.last(); ++ii)
+  {
+    auto
+      dot_rr = dot[4](ii, j),
+      dot_nr = dot[5](ii, j);
+    const auto
+      rhod = f.rhod(ii, j),
+      rr   = f.rr(ii, j),
+      nr   = f.nr(ii, j);
+    libcloudphxx::blk_2m::rhs_columnwise<real_t>(opts, dot_rr, dot_nr, rhod, rr, nr, dt, dz);
+  }
+}
+
+// wall-clock durations of n_warm + n_calc calls, the first n_warm ones discarded
+stats_t time_it(const std::function<void()> &zero, const std::function<void()> &fun, int n_warm, int n_calc)
+{
+  vector<bench_clock::time_point> stamps;
+  for (int t = 0; t < n_warm + n_calc; ++t)
+  {
+    zero(); // the rhs arrays are zeroed by libmpdata++ before each update_rhs() call
+    stamps.push_back(bench_clock::now());
+    fun();
+  }
+  stamps.push_back(bench_clock::now());
+
+  // zeroing excluded
+  vector<double> smpl;
+  for (int t = n_warm; t < n_warm + n_calc; ++t)
+    smpl.push_back(std::chrono::duration<double>(stamps[t+1] - stamps[t]).count());
+  return stats(smpl);
+}
+
+void check(const arr_t &a, const arr_t &b, const string &what)
+{
+  if (blitz::any(a != b)) error_macro("fused and two-pass tendencies differ for " << what)
+}
+
+int main(int argc, char** argv)
+{
+  const bool check_only = argc > 1 && string(argv[1]) == "--check";
+
+  const real_t dt = 1, dz = 20;
+  const int n_warm = check_only ? 0 : 2, n_calc = check_only ? 1 : 10;
+
+  libcloudphxx::blk_1m::opts_t<real_t> opts_1m;
+
+  libcloudphxx::blk_2m::opts_t<real_t> opts_2m;
+  // the two aerosol modes as in opts_blk_2m.hpp (member assignment, designated initialisers not being C++11)
+  decltype(opts_2m.dry_distros)::value_type mode1, mode2;
+  mode1.mean_rd = setup::mean_rd1 / si::metres;
+  mode1.sdev_rd = setup::sdev_rd1;
+  mode1.N_stp   = setup::n1_stp * si::cubic_metres;
+  mode1.chem_b  = setup::chem_b;
+  opts_2m.dry_distros.push_back(mode1);
+  mode2.mean_rd = setup::mean_rd2 / si::metres;
+  mode2.sdev_rd = setup::sdev_rd2;
+  mode2.N_stp   = setup::n2_stp * si::cubic_metres;
+  mode2.chem_b  = setup::chem_b;
+  opts_2m.dry_distros.push_back(mode2);
+
+  std::unique_ptr<bench_csv_t> csv;
+  if (!check_only) csv.reset(new bench_csv_t("rhs.csv", "micro,nx,nz,variant", "cells_per_s"));
+
+  auto report = [&](const string &micro, int nx, int nz, const string &variant, const stats_t &st)
+  {
+    if (!csv) return;
+    csv->row(st, {double(nx) * nz / st.median}, micro, nx, nz, variant);
+    notice_macro(micro << " " << nx << "x" << nz << " " << variant << ": " << st.median << " s (median)")
+  };
+
+  // from a cache-resident grid up to ones where the two sweeps are memory-bound
+  using grids_t = std::list<std::pair<int,int>>;
+  for (auto &nxnz : check_only ? grids_t({{76, 76}}) : grids_t({{76, 76}, {512, 512}, {1024, 1024}, {2048, 2048}}))
+  {
+    const int nx = nxnz.first, nz = nxnz.second;
+    const Range i(0, nx-1), j(0, nz-1);
+    fields_t f(nx, nz);
+
+    // blk_1m
+    {
+      arr_t dot_rc_a(nx, nz), dot_rr_a(nx, nz), dot_rc_b(nx, nz), dot_rr_b(nx, nz), dot_rc_c(nx, nz), dot_rr_c(nx, nz);
+
+      report("blk_1m", nx, nz, "two_pass", time_it(
+        [&]{ dot_rc_a = 0; dot_rr_a = 0; },
+        [&]{ two_pass_blk_1m(opts_1m, dot_rc_a, dot_rr_a, f, i, j, dz); },
+        n_warm, n_calc
+      ));
+      report("blk_1m", nx, nz, "fused", time_it(
+        [&]{ dot_rc_b = 0; dot_rr_b = 0; },
+        [&]{ rhs_fused_blk_1m(opts_1m, dot_rc_b, dot_rr_b, f.rhod, f.rc, f.rr, i, j, dz); },
+        n_warm, n_calc
+      ));
+      report("blk_1m", nx, nz, "fused_ct", time_it(
+        [&]{ dot_rc_c = 0; dot_rr_c = 0; },
+        [&]{
+          using namespace procs_blk_1m;
+          rhs_fused_blk_1m<conv | accr | sedi>(opts_1m, dot_rc_c, dot_rr_c, f.rhod, f.rc, f.rr, i, j, dz);
+        },
+        n_warm, n_calc
+      ));
+
+      check(dot_rc_a, dot_rc_b, "blk_1m rc");
+      check(dot_rr_a, dot_rr_b, "blk_1m rr");
+      check(dot_rc_a, dot_rc_c, "blk_1m rc (compile-time toggles)");
+      check(dot_rr_a, dot_rr_c, "blk_1m rr (compile-time toggles)");
+    }
+
+    // blk_2m
+    {
+      std::vector<arr_t> a, b, c;
+      for (int e = 0; e < 6; ++e)
+      {
+        a.push_back(arr_t(nx, nz));
+        b.push_back(arr_t(nx, nz));
+        c.push_back(arr_t(nx, nz));
+      }
+
+      report("blk_2m", nx, nz, "two_pass", time_it(
+        [&]{ for (auto &d : a) d = 0; },
+        [&]{ two_pass_blk_2m(opts_2m, a, f, i, j, dt, dz); },
+        n_warm, n_calc
+      ));
+      report("blk_2m", nx, nz, "fused", time_it(
+        [&]{ for (auto &d : b) d = 0; },
+        [&]{ rhs_fused_blk_2m(opts_2m, b[0], b[1], b[2], b[3], b[4], b[5], f.rhod, f.th, f.rv, f.rc, f.nc, f.rr, f.nr, i, j, dt, dz); },
+        n_warm, n_calc
+      ));
+      report("blk_2m", nx, nz, "fused_ct", time_it(
+        [&]{ for (auto &d : c) d = 0; },
+        [&]{
+          using namespace procs_blk_2m;
+          rhs_fused_blk_2m<acti | cond | acnv | accr | sedi>(opts_2m, c[0], c[1], c[2], c[3], c[4], c[5], f.rhod, f.th, f.rv, f.rc, f.nc, f.rr, f.nr, i, j, dt, dz);
+        },
+        n_warm, n_calc
+      ));
+
+      for (int e = 0; e < 6; ++e) check(a[e], b[e], "blk_2m eqn " + std::to_string(e));
+      for (int e = 0; e < 6; ++e) check(a[e], c[e], "blk_2m eqn " + std::to_string(e) + " (compile-time toggles)");
+    }
+  }
+}
@@ -0,0 +1,68 @@
+// checks that a run restarted from a checkpoint (see --checkpoint_freq and --restart)
+// ends at the same timestep as the uninterrupted one and gives the very same output,
+// both with the checkpoint taken during spinup and with the one taken after it
+
+#include <cstdlib> // system()
+#include <fstream>
+#include <list>
+#include <string>
+#include <sstream> // std::ostringstream
+
+#include <H5Cpp.h>
+
+#include "../common.hpp"
+
+using std::list;
+using std::ostringstream;
+using std::string;
+
+void call(const string &cmd)
+{
+  notice_macro("about to call: " << cmd)
+  if (EXIT_SUCCESS != system(cmd.c_str()))
+    error_macro("model run failed: " << cmd)
+}
+
+string timestep_file(const string &dir, int at)
+{
+  return dir + "/timestep" + zeropad(at, 10) + ".h5";
+}
+
+vector<double> load(const string &file, const string &dataset)
+{
+  H5::H5File h5f(file, H5F_ACC_RDONLY);
+  H5::DataSet h5d = h5f.openDataSet(dataset);
+  vector<double> ret(h5d.getSpace().getSimpleExtentNpoints());
+  h5d.read(ret.data(), H5::PredType::NATIVE_DOUBLE);
+  return ret;
+}
+
+int main(int ac, char** av)
+{
+  if (ac != 2) error_macro("expecting one argument - CMAKE_BINARY_DIR");
+
+  const int nt = 40, outfreq = 10;
+  ostringstream opts;
+  opts << av[1] << "/src/icicle --micro=blk_1m --nx=32 --nz=32 --spinup=20"
+       << " --nt=" << nt << " --outfreq=" << outfreq;
+
+  // the reference run, checkpointed every outfreq steps
+  call(opts.str() + " --outdir=out_full --checkpoint_freq=" + std::to_string(outfreq));
+
+  for (auto &at : list<int>({10, 30}))
+  {
+    const string outdir = "out_restart_" + std::to_string(at);
+    call(opts.str() + " --outdir=" + outdir + " --restart=out_full/checkpoint" + zeropad(at, 10) + ".h5");
+
+    // the last output step is there and nothing was written past it
+    if (!std::ifstream(timestep_file(outdir, nt)).good())
+      error_macro("the run restarted at timestep " << at << " did not reach timestep " << nt)
+    if (std::ifstream(timestep_file(outdir, nt + outfreq)).good())
+      error_macro("the run restarted at timestep " << at << " went past timestep " << nt)
+
+    for (int t = at + outfreq; t <= nt; t += outfreq)
+      for (auto &var : list<string>({"th", "rv", "rc", "rr"}))
+        if (load(timestep_file(outdir, t), var) != load(timestep_file("out_full", t), var))
+          error_macro(var << " at timestep " << t << " differs after restarting at timestep " << at)
+  }
+}